@@ -0,0 +1,117 @@
+// Micro benchmark for the '#include' prefilter kernels used by the header scanner
+//
+// Usage: bdg_bench_prefilter [directory]
+//
+// All regular files below directory (e.g. <boost_root>/libs) are loaded into memory and scanned
+// with each kernel. Without a directory, synthetic header content is used.
+
+#include <core/boostdep.hpp>
+#include <core/include_prefilter.hpp>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace mdev;
+using namespace mdev::boostdep;
+
+namespace {
+
+std::vector<std::string> load_files( const fs::path& dir )
+{
+	std::vector<std::string> files;
+	for( auto& entry : fs::recursive_directory_iterator( dir ) ) {
+		if( entry.is_regular_file() ) {
+			std::ifstream is( entry.path(), std::ios::binary );
+			files.emplace_back( std::istreambuf_iterator<char>( is ), std::istreambuf_iterator<char>{} );
+		}
+	}
+	return files;
+}
+
+std::vector<std::string> generate_files( std::size_t file_cnt )
+{
+	const std::vector<std::string> lines{
+		"#include <boost/config.hpp>\n",
+		"#  include \"boost/mpl/aux_/config/ctps.hpp\"\n",
+		"#include <vector>\n",
+		"#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)\n",
+		"#endif\n",
+		"// Copyright (c) 2019 The #1 Boost author\n",
+		"namespace boost { namespace detail {\n",
+		"    template<class T> struct is_foo : std::integral_constant<bool, sizeof(T) == 4> {};\n",
+		"    BOOST_STATIC_ASSERT_MSG( is_foo<int>::value, \"int has to be 4 bytes\" );\n",
+		"}} // namespace boost::detail\n",
+		"\n"};
+
+	// roughly the distribution of a typical header: few preprocessor lines and a lot of code
+	std::discrete_distribution<std::size_t> dist{2, 1, 1, 2, 2, 1, 5, 30, 20, 5, 10};
+	std::mt19937                            gen{42};
+
+	std::vector<std::string> files( file_cnt );
+	for( auto& f : files ) {
+		for( int l = 0; l < 300; ++l ) {
+			f += lines[dist( gen )];
+		}
+	}
+	return files;
+}
+
+struct Result {
+	double      seconds;
+	std::size_t hits;
+};
+
+Result run( const std::vector<std::string>& files, PrefilterKernel kernel, int reps )
+{
+	std::size_t hits  = 0;
+	const auto  start = std::chrono::steady_clock::now();
+	for( int r = 0; r < reps; ++r ) {
+		for( const auto& f : files ) {
+			hits += parse_included_boost_headers( f, kernel ).size();
+		}
+	}
+	const auto end = std::chrono::steady_clock::now();
+	return {std::chrono::duration<double>( end - start ).count(), hits / reps};
+}
+
+} // namespace
+
+int main( int argc, char** argv )
+{
+	const auto files = argc > 1 ? load_files( argv[1] ) : generate_files( 10'000 );
+
+	std::size_t total_bytes = 0;
+	for( const auto& f : files ) {
+		total_bytes += f.size();
+	}
+	fmt::print( "{} files, {:.1f} MB\n\n", files.size(), total_bytes / 1e6 );
+
+	constexpr int reps = 5;
+
+	fmt::print( "{:<8} {:>10} {:>10} {:>10} {:>8}\n", "kernel", "time[ms]", "GB/s", "speedup", "hits" );
+
+	const auto baseline = run( files, PrefilterKernel::None, reps );
+	for( auto kernel : {PrefilterKernel::None, PrefilterKernel::Scalar, PrefilterKernel::SSE2, PrefilterKernel::AVX2} ) {
+		if( !is_supported( kernel ) ) {
+			fmt::print( "{:<8} not supported on this cpu\n", to_string( kernel ) );
+			continue;
+		}
+
+		const auto r = kernel == PrefilterKernel::None ? baseline : run( files, kernel, reps );
+		fmt::print( "{:<8} {:>10.2f} {:>10.2f} {:>10.2f} {:>8}{}\n",
+					to_string( kernel ),
+					r.seconds / reps * 1e3,
+					total_bytes * reps / r.seconds / 1e9,
+					baseline.seconds / r.seconds,
+					r.hits,
+					r.hits == baseline.hits ? "" : "  MISMATCH" );
+	}
+}
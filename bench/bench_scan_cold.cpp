@@ -0,0 +1,127 @@
+// Compares the read methods of the scanner, optionally with a cold page cache
+//
+// Usage: bdg_bench_scan_cold <boost_root> [--drop-caches] [--reps N]
+//
+// With --drop-caches, the page cache is dropped before every scan (via /proc/sys/vm/drop_caches if we are root,
+// otherwise by evicting every scanned file with posix_fadvise). This is linux only.
+
+#include <core/boostdep.hpp>
+#include <core/uring_reader.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// clang-format off
+#ifdef __linux__
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+// clang-format on
+
+namespace fs = std::filesystem;
+using namespace mdev;
+using namespace mdev::boostdep;
+
+namespace {
+
+const char* to_string( ReadMethod method )
+{
+	switch( method ) {
+		case ReadMethod::Stream: return "stream";
+		case ReadMethod::MemoryMap: return "mmap";
+		case ReadMethod::IoUring: return "io_uring";
+	}
+	return "";
+}
+
+// returns false if the cache couldn't be dropped
+bool drop_page_cache( const std::vector<fs::path>& dirs )
+{
+#ifdef __linux__
+	::sync();
+	if( std::ofstream( "/proc/sys/vm/drop_caches" ) << "3" << std::flush ) {
+		return true;
+	}
+
+	// Not root: evict the files one by one (only works for pages that aren't dirty or mapped elsewhere)
+	for( const auto& dir : dirs ) {
+		for( const auto& entry : fs::recursive_directory_iterator( dir ) ) {
+			if( entry.is_regular_file() ) {
+				const int fd = ::open( entry.path().c_str(), O_RDONLY | O_CLOEXEC );
+				if( fd >= 0 ) {
+					::posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+					::close( fd );
+				}
+			}
+		}
+	}
+	return true;
+#else
+	(void)dirs;
+	return false;
+#endif
+}
+
+} // namespace
+
+int main( int argc, char** argv )
+{
+	if( argc < 2 ) {
+		fmt::print( "Usage: {} <boost_root> [--drop-caches] [--reps N]\n", argv[0] );
+		return 1;
+	}
+
+	const fs::path boost_root = argv[1];
+	bool           drop       = false;
+	int            reps       = 3;
+	for( int i = 2; i < argc; ++i ) {
+		const std::string arg = argv[i];
+		if( arg == "--drop-caches" ) {
+			drop = true;
+		} else if( arg == "--reps" && i + 1 < argc ) {
+			reps = std::max( 1, std::stoi( argv[++i] ) );
+		}
+	}
+
+	ScanOptions options;
+	const auto  dirs = get_scanned_directories( boost_root, options );
+
+	fmt::print( "io_uring {}, page cache: {}\n\n",
+				UringReader::is_supported() ? "available" : "not available (falls back to mmap)",
+				drop ? "cold" : "warm" );
+	fmt::print( "{:<10} {:>10} {:>10} {:>10}\n", "method", "time[ms]", "files", "speedup" );
+
+	double baseline = 0;
+	for( auto method : {ReadMethod::Stream, ReadMethod::MemoryMap, ReadMethod::IoUring} ) {
+		options.read_method = method;
+
+		double      best     = 0;
+		std::size_t file_cnt = 0;
+		bool        dropped  = true;
+		for( int r = 0; r < reps; ++r ) {
+			if( drop ) {
+				dropped = drop_page_cache( dirs ) && dropped;
+			}
+			const auto start = std::chrono::steady_clock::now();
+			file_cnt         = scan_all_boost_modules( boost_root, options ).size();
+			const auto time  = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+			best             = r == 0 ? time : std::min( best, time );
+		}
+		if( baseline == 0 ) {
+			baseline = best;
+		}
+
+		fmt::print( "{:<10} {:>10.1f} {:>10} {:>10.2f}{}\n",
+					to_string( method ),
+					best * 1e3,
+					file_cnt,
+					baseline / best,
+					dropped ? "" : "  (page cache not dropped)" );
+	}
+}
@@ -0,0 +1,165 @@
+// Scaling benchmark for the scanner and the analysis on generated boost trees
+//
+// Usage: bdg_bench [--dir <directory>] [--scales 1,10,100] [--reps N]
+//
+// For every scale, a synthetic tree with scale times the modules of a boost release (~15k files per 1x) is written
+// to <directory>/tree_<scale>x (default: the temp directory). Trees from a previous run are reused if they were
+// generated with the same settings, so only the first run pays for writing them.
+// A 1x tree takes about 200 MB of disk space, so 100x needs ~20 GB.
+
+#include "synthetic_tree.hpp"
+
+#include <core/boostdep.hpp>
+#include <core/file_graph.hpp>
+#include <core/file_index.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace mdev;
+using namespace mdev::boostdep;
+
+namespace {
+
+struct Result {
+	double      seconds = 0;
+	std::size_t items   = 0;
+};
+
+// best of reps runs, f returns the number of processed items
+Result measure( int reps, const std::function<std::size_t()>& f )
+{
+	Result best;
+	for( int r = 0; r < reps; ++r ) {
+		const auto start = std::chrono::steady_clock::now();
+		const auto items = f();
+		const auto time  = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+		if( r == 0 || time < best.seconds ) {
+			best = {time, items};
+		}
+	}
+	return best;
+}
+
+void print_result( std::string_view name, const Result& result )
+{
+	fmt::print( "  {:<38} {:>10.1f} {:>10} {:>12.2f}\n",
+				name,
+				result.seconds * 1e3,
+				result.items,
+				result.items == 0 ? 0.0 : result.seconds * 1e6 / double( result.items ) );
+}
+
+std::vector<double> parse_scales( const std::string& str )
+{
+	std::vector<double> scales;
+	std::istringstream  in( str );
+	std::string         token;
+	while( std::getline( in, token, ',' ) ) {
+		scales.push_back( std::stod( token ) );
+	}
+	return scales;
+}
+
+void run_benchmarks( const fs::path& boost_root, int reps )
+{
+	fmt::print( "  {:<38} {:>10} {:>10} {:>12}\n", "", "time[ms]", "items", "us/item" );
+
+	print_result( "find_modules", measure( reps, [&] { return find_boost_modules( boost_root ).size(); } ) );
+
+	ScanOptions           options;
+	std::vector<fs::path> files;
+	for( const auto& dir : get_scanned_directories( boost_root, options ) ) {
+		for( const auto& entry : fs::recursive_directory_iterator( dir ) ) {
+			if( entry.is_regular_file() ) {
+				files.push_back( entry.path() );
+			}
+		}
+	}
+	print_result( "get_included_boost_headers (1 thread)", measure( reps, [&] {
+					  for( const auto& file : files ) {
+						  get_included_boost_headers( file, options );
+					  }
+					  return files.size();
+				  } ) );
+
+	std::vector<FileInfo> scanned;
+	print_result( "scan_all_boost_modules", measure( reps, [&] {
+					  scanned = scan_all_boost_modules( boost_root, options );
+					  return scanned.size();
+				  } ) );
+	options.strategy = ScanStrategy::Pipeline;
+	print_result( "scan_all_boost_modules (pipeline)",
+				  measure( reps, [&] { return scan_all_boost_modules( boost_root, options ).size(); } ) );
+
+	// the module with the highest index sits on top of the dependency DAG
+	const auto modules = find_boost_modules( boost_root );
+	const auto root    = modules.empty() ? String_t{} : modules.rbegin()->first;
+
+	print_result( "build_module_dependency_map",
+				  measure( reps, [&] { return build_module_dependency_map( scanned ).size(); } ) );
+	print_result( "build_filtered_module_dependency_map",
+				  measure( reps, [&] { return build_filtered_module_dependency_map( scanned, root ).size(); } ) );
+	print_result( "build_filtered_file_dependency_map",
+				  measure( reps, [&] { return build_filtered_file_dependency_map( scanned, root ).size(); } ) );
+
+	// what a per-module report does
+	const FileIndex index( scanned );
+	print_result( "filtered module maps of all modules", measure( reps, [&] {
+					  for( const auto& [name, path] : modules ) {
+						  build_filtered_module_dependency_map( index, name );
+					  }
+					  return modules.size();
+				  } ) );
+	const auto graph = make_file_graph( scanned );
+	print_result( "filtered module maps (batch)",
+				  measure( reps, [&] { return build_all_filtered_module_dependency_maps( graph ).size(); } ) );
+}
+
+} // namespace
+
+int main( int argc, char** argv )
+{
+	fs::path            dir    = fs::temp_directory_path() / "bdg_bench";
+	std::vector<double> scales = {1, 10, 100};
+	int                 reps   = 3;
+	for( int i = 1; i < argc; ++i ) {
+		const std::string arg = argv[i];
+		if( arg == "--dir" && i + 1 < argc ) {
+			dir = argv[++i];
+		} else if( arg == "--scales" && i + 1 < argc ) {
+			scales = parse_scales( argv[++i] );
+		} else if( arg == "--reps" && i + 1 < argc ) {
+			reps = std::max( 1, std::stoi( argv[++i] ) );
+		} else {
+			fmt::print( "Usage: {} [--dir <directory>] [--scales 1,10,100] [--reps N]\n", argv[0] );
+			return 1;
+		}
+	}
+
+	for( const auto scale : scales ) {
+		const auto config = bench::SyntheticTreeConfig::scaled( scale );
+		const auto root   = dir / fmt::format( "tree_{}x", scale );
+
+		const auto start = std::chrono::steady_clock::now();
+		const auto info  = bench::generate_synthetic_tree( root, config );
+		const auto time  = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+		fmt::print( "\n{}x: {} files, {} modules, {} includes ({} in {:.1f}s)\n",
+					scale,
+					info.files,
+					info.modules,
+					info.includes,
+					info.reused ? "reused" : "generated",
+					time );
+		run_benchmarks( root, reps );
+	}
+}
@@ -0,0 +1,235 @@
+#include "synthetic_tree.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace mdev::bench {
+
+namespace {
+
+constexpr const char* marker_file = ".bdg_synthetic_tree";
+
+struct Header {
+	std::size_t module_index; // sublibs share the index of their parent
+	std::string include_name; // e.g. boost/mod007/detail/file_12.hpp
+};
+
+struct Module {
+	std::string name;      // directory below libs, e.g. mod007 or mod007/sub1
+	fs::path    dir;       // libs/<name>
+	std::string boost_dir; // boost/mod007 or boost/mod007/sub1
+	std::size_t index        = 0;
+	std::size_t header_cnt   = 0;
+	std::size_t first_header = 0; // position in the global header list
+};
+
+const char* const std_headers[] = {"vector", "string", "memory", "type_traits", "utility", "cstddef", "iterator"};
+
+// a mix of typical header lines, none of them is an include
+const char* const code_lines[] = {
+	"namespace boost { namespace detail {",
+	"template<class T, class Alloc = std::allocator<T>> struct holder : std::integral_constant<bool, true> {};",
+	"    BOOST_STATIC_ASSERT_MSG( sizeof( T ) >= 1, \"incomplete type\" );",
+	"#if !defined( BOOST_NO_CXX11_RVALUE_REFERENCES ) && !defined( BOOST_NO_CXX11_VARIADIC_TEMPLATES )",
+	"#endif // BOOST_NO_CXX11_RVALUE_REFERENCES",
+	"// Copyright (c) 2020 The #1 synthetic boost author. Distributed under the Boost Software License",
+	"    template<class U> static auto test( int ) -> decltype( std::declval<U&>().foo(), std::true_type{} );",
+	"    typedef typename remove_cv<typename remove_reference<T>::type>::type type;",
+	"}} // namespace boost::detail",
+	"",
+};
+
+std::string guard_name( const std::string& include_name )
+{
+	std::string guard = include_name;
+	for( auto& c : guard ) {
+		c = std::isalnum( static_cast<unsigned char>( c ) ) ? static_cast<char>( std::toupper( c ) ) : '_';
+	}
+	return guard + "_INCLUDED";
+}
+
+class Generator {
+public:
+	Generator( const fs::path& root, const SyntheticTreeConfig& config )
+		: _root( root )
+		, _config( config )
+		, _gen( config.seed )
+	{
+	}
+
+	SyntheticTreeInfo run()
+	{
+		create_modules();
+		for( const auto& m : _modules ) {
+			write_module( m );
+		}
+		SyntheticTreeInfo info;
+		info.files    = _files;
+		info.modules  = _modules.size();
+		info.includes = _includes;
+		return info;
+	}
+
+private:
+	void create_modules()
+	{
+		const auto add = [&]( std::string name, std::string boost_dir, std::size_t index, std::size_t headers ) {
+			Module m;
+			m.name         = std::move( name );
+			m.dir          = _root / "libs" / m.name;
+			m.boost_dir    = std::move( boost_dir );
+			m.index        = index;
+			m.header_cnt   = std::max<std::size_t>( 1, headers );
+			m.first_header = _headers.size();
+			for( std::size_t i = 0; i < m.header_cnt; ++i ) {
+				// every 4th file lives in a detail directory, like in most boost libraries
+				const auto sub = i % 4 == 3 ? "/detail/file_" : "/file_";
+				_headers.push_back( {index, m.boost_dir + sub + std::to_string( i ) + ".hpp"} );
+			}
+			_modules.push_back( std::move( m ) );
+		};
+
+		for( std::size_t i = 0; i < _config.modules; ++i ) {
+			char name[32];
+			std::snprintf( name, sizeof( name ), "mod%05zu", i );
+			add( name, std::string( "boost/" ) + name, i, _config.files_per_module );
+			if( i < _config.sublib_modules ) {
+				for( int s = 0; s < 2; ++s ) {
+					const auto sub = "sub" + std::to_string( s );
+					add( std::string( name ) + "/" + sub,
+						 std::string( "boost/" ) + name + "/" + sub,
+						 i,
+						 _config.files_per_module / 4 );
+				}
+			}
+		}
+	}
+
+	// Cross module includes only go to modules with a lower index, so the modules form a DAG (like boost should)
+	const std::string& pick_include( const Module& m )
+	{
+		std::bernoulli_distribution cross( _config.cross_module_ratio );
+		if( m.index > 0 && cross( _gen ) ) {
+			// the headers are ordered by module index, so everything before our first header is a candidate
+			std::size_t end = m.first_header;
+			while( end > 0 && _headers[end - 1].module_index == m.index ) {
+				--end; // skip the parent / sibling sublibs
+			}
+			if( end > 0 ) {
+				return _headers[std::uniform_int_distribution<std::size_t>( 0, end - 1 )( _gen )].include_name;
+			}
+		}
+		const auto i = std::uniform_int_distribution<std::size_t>( 0, m.header_cnt - 1 )( _gen );
+		return _headers[m.first_header + i].include_name;
+	}
+
+	void write_file( const fs::path& file, const Module& m, const std::string& guard )
+	{
+		std::ostringstream out;
+		if( !guard.empty() ) {
+			out << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+		}
+
+		// between 0.5x and 1.5x the average
+		const auto includes = std::uniform_int_distribution<std::size_t>(
+			_config.includes_per_file / 2, _config.includes_per_file + _config.includes_per_file / 2 )( _gen );
+		for( std::size_t i = 0; i < includes; ++i ) {
+			// some variation in the syntax, so the parser can't take shortcuts
+			if( i % 3 == 2 ) {
+				out << "#  include \"" << pick_include( m ) << "\"\n";
+			} else {
+				out << "#include <" << pick_include( m ) << ">\n";
+			}
+		}
+		out << "#include <" << std_headers[_files % std::size( std_headers )] << ">\n\n";
+		_includes += includes;
+
+		std::uniform_int_distribution<std::size_t> line( 0, std::size( code_lines ) - 1 );
+		for( std::size_t i = 0; i < _config.lines_per_file; ++i ) {
+			out << code_lines[line( _gen )] << '\n';
+		}
+		if( !guard.empty() ) {
+			out << "\n#endif // " << guard << '\n';
+		}
+
+		fs::create_directories( file.parent_path() );
+		std::ofstream( file, std::ios::binary ) << out.str();
+		_files++;
+	}
+
+	void write_module( const Module& m )
+	{
+		for( std::size_t i = 0; i < m.header_cnt; ++i ) {
+			const auto& name = _headers[m.first_header + i].include_name;
+			write_file( m.dir / "include" / name, m, guard_name( name ) );
+		}
+		for( std::size_t i = 0; i < _config.sources_per_module; ++i ) {
+			write_file( m.dir / "src" / ( "source_" + std::to_string( i ) + ".cpp" ), m, "" );
+		}
+		if( m.index < _config.sublib_modules && m.name.find( '/' ) == std::string::npos ) {
+			std::ofstream( m.dir / "sublibs" ) << "sub0\nsub1\n";
+		}
+	}
+
+	fs::path            _root;
+	SyntheticTreeConfig _config;
+	std::mt19937        _gen;
+
+	std::vector<Module> _modules;
+	std::vector<Header> _headers;
+	std::size_t         _files    = 0;
+	std::size_t         _includes = 0;
+};
+
+} // namespace
+
+SyntheticTreeConfig SyntheticTreeConfig::scaled( double scale )
+{
+	SyntheticTreeConfig config;
+	config.modules        = static_cast<std::size_t>( std::lround( double( config.modules ) * scale ) );
+	config.sublib_modules = static_cast<std::size_t>( std::lround( double( config.sublib_modules ) * scale ) );
+	return config;
+}
+
+std::string SyntheticTreeConfig::describe() const
+{
+	std::ostringstream out;
+	out << modules << " modules, " << files_per_module << " headers + " << sources_per_module << " sources each, "
+		<< sublib_modules << " with sublibs, " << includes_per_file << " includes per file ("
+		<< cross_module_ratio * 100 << "% cross module), " << lines_per_file << " lines, seed " << seed;
+	return out.str();
+}
+
+SyntheticTreeInfo generate_synthetic_tree( const fs::path& root, const SyntheticTreeConfig& config )
+{
+	SyntheticTreeInfo info;
+	{
+		std::ifstream marker( root / marker_file );
+		std::string   description;
+		if( std::getline( marker, description ) && description == config.describe()
+			&& marker >> info.files >> info.modules >> info.includes ) {
+			info.reused = true;
+			return info;
+		}
+	}
+
+	fs::remove_all( root );
+	fs::create_directories( root / "libs" );
+	info = Generator( root, config ).run();
+
+	// written last, so an interrupted run is never mistaken for a complete tree
+	std::ofstream( root / marker_file ) << config.describe() << '\n'
+										<< info.files << ' ' << info.modules << ' ' << info.includes << '\n';
+	return info;
+}
+
+} // namespace mdev::bench
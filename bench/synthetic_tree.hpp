@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+
+namespace mdev::bench {
+
+// Shape of a generated boost tree. The defaults are roughly the size of a real boost release
+struct SyntheticTreeConfig {
+	std::size_t modules            = 150;
+	std::size_t files_per_module   = 100; // headers in include/boost/<module>/
+	std::size_t sources_per_module = 3;   // files in src/
+	std::size_t sublib_modules     = 10;  // number of modules that get two sublibs (like numeric~conversion)
+	std::size_t includes_per_file  = 8;   // average number of boost includes per file
+	double      cross_module_ratio = 0.3; // fraction of the includes that refer to another module
+	std::size_t lines_per_file     = 150; // lines of (fake) code around the includes
+	unsigned    seed               = 42;
+
+	// multiplies the number of modules
+	static SyntheticTreeConfig scaled( double scale );
+
+	// one line summary, also used to recognize an up to date tree
+	std::string describe() const;
+};
+
+struct SyntheticTreeInfo {
+	std::size_t files    = 0;
+	std::size_t modules  = 0; // including sublibs
+	std::size_t includes = 0;
+	bool        reused   = false; // the tree was already there
+};
+
+// Writes libs/<module>/include/boost/<module>/... (and src, sublibs) below root.
+// If root already contains a tree generated with the same config, it is left alone. Otherwise root is cleared.
+SyntheticTreeInfo generate_synthetic_tree( const std::filesystem::path& root, const SyntheticTreeConfig& config );
+
+} // namespace mdev::bench
@@ -6,6 +6,13 @@
 #include <core/ModuleInfo.hpp>
 #include <core/analysis.hpp>
 #include <core/boostdep.hpp>
+#include <core/content_dedup.hpp>
+#include <core/file_classifier.hpp>
+#include <core/file_graph.hpp>
+#include <core/scan_cache.hpp>
+#include <core/snapshot.hpp>
+#include <core/stats_report.hpp>
+#include <core/tree_watcher.hpp>
 
 #include <QListView>
 #include <QPushButton>
@@ -24,7 +31,10 @@
 
 #include <algorithm>
 #include <cassert>
+#include <exception>
 #include <chrono>
+#include <fstream>
+#include <iostream>
 #include <map>
 #include <numeric>
 #include <optional>
@@ -74,31 +84,227 @@ int main( int argc, char** argv )
 
 	auto graph_widget = new gui::GraphWidget();
 
-	// This data is referenced from multiple places in the UI, so it has to stay alive as long as the app is running
+	// This data is referenced from multiple places in the UI, so it has to stay alive as long as the app is running.
+	// After loading a snapshot, file_infos stays empty until watch mode or the file lists need it (ensure_file_infos)
 	std::vector<boostdep::FileInfo> file_infos;
 	modules_data                    modules;
 	std::filesystem::path           boost_root;
 
+	// file_infos with all includes resolved to file ids, rebuilt whenever file_infos changes
+	boostdep::FileGraph file_graph;
+	CMakeStatus         cmake_status;
+
+	std::optional<String_t>         root_lib;
+
+	// Only files that changed since the last scan (of this or a previous run) have to be parsed again
+	boostdep::ScanCache   scan_cache;
+	std::filesystem::path scan_cache_file;
+
+	boostdep::ScanOptions scan_options;
+	scan_options.track_sources = boostdep::TrackSources::Yes;
+	scan_options.track_tests   = boostdep::TrackTests::No;
+	scan_options.cache         = &scan_cache;
+
+	// docs, images, build files etc. can't include anything
+	const boostdep::FileClassifier classifier;
+	scan_options.classifier = &classifier;
+
+	// --revision <commit/branch/tag>: analyze an older boost release straight from the git repositories
+	// Blobs that were parsed once don't have to be read again on a rescan
+	boostdep::ContentDedupTable dedup_table;
+	if( const auto idx = app.arguments().indexOf( "--revision" ); idx >= 0 && idx + 1 < app.arguments().size() ) {
+		scan_options.git_revision = app.arguments()[idx + 1].toStdString();
+		scan_options.cache        = nullptr;
+		scan_options.dedup        = &dedup_table;
+	}
+
+	// --pipeline: separate walker/reader/parser threads instead of the work stealing scan
+	if( app.arguments().contains( "--pipeline" ) ) {
+		scan_options.strategy = boostdep::ScanStrategy::Pipeline;
+	}
+
+	// --include-roots <root1,root2,...>: collect includes below other roots than boost/ (e.g. in a monorepo)
+	std::optional<boostdep::IncludeMatcher> include_matcher;
+	if( const auto idx = app.arguments().indexOf( "--include-roots" ); idx >= 0 && idx + 1 < app.arguments().size() ) {
+		std::vector<String_t> roots;
+		for( const auto& root : app.arguments()[idx + 1].split( ',' ) ) {
+			if( !root.isEmpty() ) {
+				roots.push_back( root.toStdString() );
+			}
+		}
+		if( !roots.empty() ) {
+			include_matcher.emplace( roots );
+			scan_options.include_matcher = &*include_matcher;
+			scan_options.cache           = nullptr; // the cached entries were created for boost/
+		}
+	}
+
+	// --stats-json <file>: dump the timings and counters of the last scan and analysis
+	std::filesystem::path stats_file;
+	if( const auto idx = app.arguments().indexOf( "--stats-json" ); idx >= 0 && idx + 1 < app.arguments().size() ) {
+		stats_file = app.arguments()[idx + 1].toStdString();
+	}
+	boostdep::ScanStats scan_stats;
+
+	// --save-snapshot <file>: write the result of every scan to file
+	// --load-snapshot <file>: start with the scan result from file instead of scanning (use reload for a real scan)
+	std::filesystem::path save_snapshot_file;
+	std::filesystem::path load_snapshot_file;
+	if( const auto idx = app.arguments().indexOf( "--save-snapshot" ); idx >= 0 && idx + 1 < app.arguments().size() ) {
+		save_snapshot_file = app.arguments()[idx + 1].toStdString();
+	}
+	if( const auto idx = app.arguments().indexOf( "--load-snapshot" ); idx >= 0 && idx + 1 < app.arguments().size() ) {
+		load_snapshot_file = app.arguments()[idx + 1].toStdString();
+	}
+
 	using namespace std::chrono;
 	using namespace std::chrono_literals;
 
-	auto rescan = [&file_infos, &boost_root]() {
+	auto update_cmake_status = [&] {
+		std::vector<String_t> module_names;
+		for( const auto& [name, path] : boostdep::find_boost_modules( boost_root ) ) {
+			module_names.push_back( name );
+		}
+		cmake_status = find_cmake_status( boost_root, module_names );
+	};
+
+	auto ensure_file_infos = [&] {
+		if( file_infos.empty() && file_graph.file_count() != 0 ) {
+			file_infos = boostdep::to_file_infos( file_graph );
+		}
+	};
+
+	auto scan = [&]() {
+		const auto cache_file = boostdep::default_cache_location( boost_root );
+		if( scan_options.cache && cache_file != scan_cache_file ) {
+			scan_cache_file = cache_file;
+			scan_cache.load( scan_cache_file );
+		}
+
+		scan_stats = {};
+		try {
+			file_infos = boostdep::scan_all_boost_modules( boost_root, scan_options, &scan_stats );
+		} catch( const std::exception& e ) {
+			fmt::print( "Scan failed: {}\n", e.what() );
+			file_infos.clear();
+			file_graph = {};
+			return;
+		}
+		file_graph = boostdep::make_file_graph( file_infos );
+		update_cmake_status();
+
+		if( !save_snapshot_file.empty() ) {
+			const boostdep::ScanSnapshot snapshot{boost_root, file_graph, cmake_status};
+			if( !snapshot.save( save_snapshot_file ) ) {
+				fmt::print( "Could not write snapshot {}\n", save_snapshot_file.string() );
+			}
+		}
+
+		fmt::print( "Scan thread utilization:\n" );
+		for( std::size_t i = 0; i < scan_stats.workers.size(); ++i ) {
+			const auto& w = scan_stats.workers[i];
+			fmt::print( "  thread {:>3}: {:>6} tasks {:>5} steals {:>6.1f}% busy\n",
+						i,
+						w.tasks,
+						w.steals,
+						w.utilization() * 100 );
+		}
+		for( const auto& stage : scan_stats.stages ) {
+			fmt::print( "  stage {:>5}: {:>3} threads {:>6} files {:>6.1f}% busy, queue max {:>4} avg {:>6.1f} of {}\n",
+						stage.name,
+						stage.threads,
+						stage.items,
+						stage.utilization() * 100,
+						stage.input.max_depth,
+						stage.input.avg_depth,
+						stage.input.capacity );
+		}
+
+		boostdep::print_stats( std::cout, scan_stats );
+
+		if( !scan_options.cache ) {
+			return;
+		}
+		fmt::print( "Reused {} of {} files from scan cache\n", scan_cache.hits(), file_infos.size() );
+		if( !scan_cache.save( scan_cache_file ) ) {
+			fmt::print( "Could not write scan cache {}\n", scan_cache_file.string() );
+		}
+	};
+
+	auto rescan = [&boost_root, &scan]() {
 		boost_root = determine_boost_root();
-		file_infos
-			= boostdep::scan_all_boost_modules( boost_root, boostdep::TrackSources::Yes, boostdep::TrackTests::No );
+		scan();
 	};
 
-	auto redo_analysis = [&modules, &graph_widget, &file_infos, &boost_root] {
-		auto root_lib = get_root_library_name();
-		auto start    = system_clock::now();
-		//for( int i = 0; i < 100; ++i ) {
-			modules       = generate_module_list( file_infos, boost_root, root_lib, filter );
-		//}
-		auto end      = system_clock::now();
-		fmt::print( "\nDuration was: {}ms\n\n", ( end - start ) / 1ms );
+	auto analyze = [&] {
+		boostdep::AnalysisStats analysis_stats;
+		modules = generate_module_list( file_graph, boost_root, root_lib, filter, &analysis_stats, &cmake_status );
+		std::cout << '\n';
+		boostdep::print_unresolved_includes( std::cout, analysis_stats.unresolved );
+		std::cout << '\n';
+		boostdep::print_stats( std::cout, analysis_stats );
+		std::cout << std::endl;
+
+		if( !stats_file.empty() ) {
+			std::ofstream( stats_file ) << "{\"scan\":" << boostdep::to_json( scan_stats )
+										<< ",\"analysis\":" << boostdep::to_json( analysis_stats ) << "}\n";
+		}
 		graph_widget->set_data( &modules );
 	};
 
+	auto redo_analysis = [&root_lib, &analyze] {
+		root_lib = get_root_library_name();
+		analyze();
+	};
+
+	// In watch mode, changed files are rescanned and the graph is updated as soon as they are saved
+	boostdep::TreeWatcher tree_watcher;
+
+	auto apply_tree_changes = [&] {
+		auto changes = tree_watcher.take_changes();
+		if( changes.overflow ) {
+			scan();
+		} else if( boostdep::rescan_paths( file_infos, boost_root, changes.paths, scan_options ) ) {
+			file_graph = boostdep::make_file_graph( file_infos );
+			update_cmake_status(); // cheap, and CMakeLists.txt may have been added together with the sources
+		} else {
+			return;
+		}
+		graph_widget->clear();
+		analyze();
+	};
+
+	auto start_watching = [&] {
+		if( !scan_options.git_revision.empty() ) {
+			fmt::print( "Watch mode is not available for --revision, a commit never changes\n" );
+			return;
+		}
+		ensure_file_infos(); // rescan_paths updates file_infos
+		const auto dirs = boostdep::get_scanned_directories( boost_root, scan_options );
+		const bool ok   = tree_watcher.start( dirs, [&] {
+			// we are on the watcher thread here
+			QMetaObject::invokeMethod( graph_widget, apply_tree_changes, Qt::QueuedConnection );
+		} );
+		if( !ok ) {
+			fmt::print( "Watch mode is not supported on this platform\n" );
+		} else {
+			fmt::print( "Watching {} directories for changes\n", dirs.size() );
+			if( tree_watcher.failed_watch_count() != 0 ) {
+				fmt::print( "Could not watch {} directories (inotify watch limit reached?)\n",
+							tree_watcher.failed_watch_count() );
+			}
+		}
+	};
+
+	auto toggle_watch_mode = [&] {
+		if( tree_watcher.is_running() ) {
+			tree_watcher.stop();
+			fmt::print( "Watch mode disabled\n" );
+		} else {
+			start_watching();
+		}
+	};
+
 	auto print_stats  = [&] { print_cmake_stats( modules ); };
 	auto print_cycles = [&] {
 		fmt::print(
@@ -116,26 +322,68 @@ int main( int argc, char** argv )
 
 		print_stats();
 		print_cycles();
+
+		if( tree_watcher.is_running() ) {
+			start_watching(); // boost root might have changed
+		}
+	};
+
+	auto load_snapshot = [&] {
+		const auto             start = steady_clock::now();
+		boostdep::ScanSnapshot snapshot;
+		if( !snapshot.load( load_snapshot_file ) ) {
+			fmt::print( "Could not load snapshot {}\n", load_snapshot_file.string() );
+			return false;
+		}
+		boost_root   = std::move( snapshot.boost_root );
+		file_graph   = std::move( snapshot.files );
+		cmake_status = std::move( snapshot.has_cmake );
+		file_infos.clear(); // only built if needed, see ensure_file_infos
+		fmt::print( "Loaded snapshot of {} ({} files) in {}us\n",
+					boost_root.string(),
+					file_graph.file_count(),
+					duration_cast<microseconds>( steady_clock::now() - start ).count() );
+
+		redo_analysis();
+		print_stats();
+		print_cycles();
+		return true;
 	};
 
-	rescanfull();
+	if( load_snapshot_file.empty() || !load_snapshot() ) {
+		rescanfull();
+	}
+
+	if( app.arguments().contains( "--watch" ) ) {
+		start_watching();
+	}
 
 	QMainWindow main_window;
 
-	DisplayFileList     list( &file_infos );
-	TreeDisplayFileList treelist( &file_infos );
+	// The file lists aren't part of the layout at the moment, so their models (and file_infos) aren't built either
+	constexpr bool show_file_lists = false;
+
+	std::optional<DisplayFileList>     list;
+	std::optional<TreeDisplayFileList> treelist;
 
 	QTableView*        tableview = new QTableView();
 	QAbstractItemView* treeview  = new QTreeView();
 	// QListView*   listview = new QListView();
-	tableview->setModel( &list );
-	treeview->setModel( &treelist );
+	if( show_file_lists ) {
+		ensure_file_infos();
+		list.emplace( &file_infos );
+		treelist.emplace( &file_infos );
+		tableview->setModel( &*list );
+		treeview->setModel( &*treelist );
+	}
 	// listview->setModelColumn( 1 );
 
 	QSplitter* layout = new QSplitter();
 	layout->addWidget( graph_widget );
-	//layout->addWidget( tableview );
-	//layout->addWidget( treeview );
+	if( show_file_lists ) {
+		layout->addWidget( tableview );
+		layout->addWidget( treeview );
+	}
 
 	main_window.setCentralWidget( layout );
 
@@ -143,8 +391,13 @@ int main( int argc, char** argv )
 	QObject::connect( graph_widget, &gui::GraphWidget::reset_requested, redo_analysis );
 	QObject::connect( graph_widget, &gui::GraphWidget::reprint_stats_requested, print_stats );
 	QObject::connect( graph_widget, &gui::GraphWidget::cycle_dedection_requested, print_cycles );
+	QObject::connect( graph_widget, &gui::GraphWidget::watch_mode_toggle_requested, toggle_watch_mode );
 	main_window.show();
 
 	// list.update();
-	return app.exec();
+	const int ret = app.exec();
+
+	// make sure the watcher thread doesn't post any more events
+	tree_watcher.stop();
+	return ret;
 }
@@ -55,28 +55,24 @@ void update_info( std::vector<boostdep::FileInfo>& files, const std::map<String_
 	}
 }
 
-void set_direct_deps( bdg::modules_data& modules, boostdep::DependencyInfo deps )
+// nodes[n]: module of node n of deps (nullptr if it was excluded)
+void set_direct_deps( const boostdep::DependencyGraph& deps, const std::vector<bdg::ModuleInfo*>& nodes )
 {
-	for( auto& [name1, info1] : modules ) {
-		for( auto& [name2, info2] : modules ) {
-			if( std::count( deps[name1].begin(), deps[name1].end(), name2 ) != 0 ) {
-				info1.deps.insert( &info2 );
-				info2.rev_deps.insert( &info1 );
+	for( boostdep::DependencyGraph::NodeId n = 0; n < deps.size(); ++n ) {
+		if( !nodes[n] ) {
+			continue;
+		}
+		for( const auto d : deps.deps( n ) ) {
+			if( nodes[d] ) {
+				nodes[n]->deps.insert( nodes[d] );
 			}
 		}
-	}
-}
-
-template<class T, class F>
-T filter( const T& data, const F& exclude )
-{
-	T ret;
-	for( const auto& e : data ) {
-		if( std::count( exclude.begin(), exclude.end(), e ) == 0 ) {
-			ret.push_back( e );
+		for( const auto r : deps.rev_deps( n ) ) {
+			if( nodes[r] ) {
+				nodes[n]->rev_deps.insert( nodes[r] );
+			}
 		}
 	}
-	return ret;
 }
 
 std::string replace( const String_t& src, char match, char replacement )
@@ -86,29 +82,46 @@ std::string replace( const String_t& src, char match, char replacement )
 	return ret;
 }
 
-bdg::modules_data process_dpendency_map( const boostdep::DependencyInfo& dependency_map,
-										 const std::filesystem::path     boost_root,
-										 const std::vector<String_t>&    exclude )
+// Modules that aren't part of cmake_status are looked up in the file system
+bool has_cmake_file( const std::filesystem::path& boost_root,
+					 const String_t&              module,
+					 const bdg::CMakeStatus*      cmake_status )
 {
-
-	std::vector<String_t> module_names;
-	for( auto [name, ignore] : dependency_map ) {
-		module_names.push_back( name );
+	if( cmake_status ) {
+		if( auto it = cmake_status->find( module ); it != cmake_status->end() ) {
+			return it->second;
+		}
 	}
 
-	bdg::modules_data data;
-	for( auto& name : filter( module_names, exclude ) ) {
+	std::string relative_path_to_root = replace( module, '~', '/' );
 
-		std::string relative_path_to_root = replace( name, '~', '/' );
+	return std::filesystem::exists( boost_root / "libs" / relative_path_to_root / "CMakeLists.txt" );
+}
 
-		bool has_cmake = std::filesystem::exists( boost_root / "libs" / relative_path_to_root / "CMakeLists.txt" );
+bdg::modules_data process_dpendency_map( const boostdep::DependencyGraph& dependency_map,
+										 const std::filesystem::path      boost_root,
+										 const std::vector<String_t>&     exclude,
+										 boostdep::AnalysisStats*         stats,
+										 const bdg::CMakeStatus*          cmake_status = nullptr )
+{
+	ScopedTimer timer( stats ? &stats->total : nullptr );
+
+	bdg::modules_data             data;
+	std::vector<bdg::ModuleInfo*> nodes( dependency_map.size(), nullptr );
+	for( boostdep::DependencyGraph::NodeId n = 0; n < dependency_map.size(); ++n ) {
+		const String_t name( dependency_map.name( n ) );
+		if( std::count( exclude.begin(), exclude.end(), name ) != 0 ) {
+			continue;
+		}
+
+		bool has_cmake = has_cmake_file( boost_root, name, cmake_status );
 
-		data[name] = bdg::ModuleInfo{name, has_cmake};
+		nodes[n] = &( data[name] = bdg::ModuleInfo{name, has_cmake} );
 	}
 
-	set_direct_deps( data, dependency_map );
+	set_direct_deps( dependency_map, nodes );
 
-	update_derived_information( data );
+	update_derived_information( data, stats );
 
 	return data;
 }
@@ -117,27 +130,85 @@ bdg::modules_data process_dpendency_map( const boostdep::DependencyInfo& depende
 
 namespace bdg {
 
+namespace {
+
+// Files is either the scan result (std::vector<FileInfo>) or a FileGraph
+template<class Files>
+modules_data generate_file_list_impl( const Files&                 files,
+									  std::filesystem::path        boost_root,
+									  String_t                     root_module,
+									  const std::vector<String_t>& exclude,
+									  boostdep::AnalysisStats*     stats,
+									  const CMakeStatus*           cmake_status )
+{
+	const auto dependency_map = boostdep::build_filtered_file_dependency_map( files, root_module, stats );
+	return process_dpendency_map( dependency_map, boost_root, exclude, stats, cmake_status );
+}
+
+template<class Files>
+modules_data generate_module_list_impl( const Files&                   files,
+										std::filesystem::path          boost_root,
+										const std::optional<String_t>& root_module,
+										const std::vector<String_t>&   exclude,
+										boostdep::AnalysisStats*       stats,
+										const CMakeStatus*             cmake_status )
+{
+	if( root_module ) {
+		const auto dependency_map = boostdep::build_filtered_module_dependency_map( files, root_module.value(), stats );
+		return process_dpendency_map( dependency_map, boost_root, exclude, stats, cmake_status );
+	} else {
+		const auto dependency_map = boostdep::build_module_dependency_map( files, stats );
+		return process_dpendency_map( dependency_map, boost_root, exclude, stats, cmake_status );
+	}
+}
+
+} // namespace
+
 modules_data generate_file_list( const std::vector<boostdep::FileInfo>& files,
 								 std::filesystem::path                  boost_root,
 								 String_t                               root_module,
-								 const std::vector<String_t>&           exclude )
+								 const std::vector<String_t>&           exclude,
+								 boostdep::AnalysisStats*               stats )
 {
-	const auto dependency_map = boostdep::build_filtered_file_dependency_map( files, root_module );
-	return process_dpendency_map( dependency_map, boost_root, exclude );
+	return generate_file_list_impl( files, boost_root, root_module, exclude, stats, nullptr );
+}
+
+modules_data generate_file_list( const boostdep::FileGraph&   files,
+								 std::filesystem::path        boost_root,
+								 String_t                     root_module,
+								 const std::vector<String_t>& exclude,
+								 boostdep::AnalysisStats*     stats,
+								 const CMakeStatus*           cmake_status )
+{
+	return generate_file_list_impl( files, boost_root, root_module, exclude, stats, cmake_status );
 }
 
 modules_data generate_module_list( const std::vector<boostdep::FileInfo>& files,
 								   std::filesystem::path                  boost_root,
 								   const std::optional<String_t>&         root_module,
-								   const std::vector<String_t>&           exclude )
+								   const std::vector<String_t>&           exclude,
+								   boostdep::AnalysisStats*               stats )
 {
-	if( root_module ) {
-		const auto dependency_map = boostdep::build_filtered_module_dependency_map( files, root_module.value() );
-		return process_dpendency_map( dependency_map, boost_root, exclude );
-	} else {
-		const auto dependency_map = boostdep::build_module_dependency_map( files );
-		return process_dpendency_map( dependency_map, boost_root, exclude );
+	return generate_module_list_impl( files, boost_root, root_module, exclude, stats, nullptr );
+}
+
+modules_data generate_module_list( const boostdep::FileGraph&     files,
+								   std::filesystem::path          boost_root,
+								   const std::optional<String_t>& root_module,
+								   const std::vector<String_t>&   exclude,
+								   boostdep::AnalysisStats*       stats,
+								   const CMakeStatus*             cmake_status )
+{
+	return generate_module_list_impl( files, boost_root, root_module, exclude, stats, cmake_status );
+}
+
+CMakeStatus find_cmake_status( const std::filesystem::path& boost_root, const std::vector<String_t>& modules )
+{
+	CMakeStatus ret;
+	for( const auto& m : modules ) {
+		ret[m] = has_cmake_file( boost_root, m, nullptr );
 	}
+	return ret;
 }
 
 //########## #
@@ -222,10 +293,16 @@ void update_cmake_status( modules_data& modules )
 	}
 }
 
-void update_derived_information( modules_data& modules )
+void update_derived_information( modules_data& modules, boostdep::AnalysisStats* stats )
 {
-	update_transitive_dependencies( modules );
-	update_module_levels( modules );
+	{
+		ScopedTimer timer( stats ? &stats->closure_time : nullptr );
+		update_transitive_dependencies( modules );
+	}
+	{
+		ScopedTimer timer( stats ? &stats->level_time : nullptr );
+		update_module_levels( modules );
+	}
 	update_cmake_status( modules );
 }
 
@@ -2,6 +2,7 @@
 
 #include "ModuleInfo.hpp"
 #include "boostdep.hpp"
+#include "file_graph.hpp"
 
 #include "utils.hpp"
 
@@ -18,14 +19,38 @@ namespace mdev::bdg {
 modules_data generate_file_list( const std::vector<boostdep::FileInfo>& files,
 								 std::filesystem::path                  boost_root,
 								 String_t                               root_module,
-								 const std::vector<String_t>&           exclude = {} );
+								 const std::vector<String_t>&           exclude = {},
+								 boostdep::AnalysisStats*               stats   = nullptr );
 
 modules_data generate_module_list( const std::vector<boostdep::FileInfo>& files,
 								   std::filesystem::path                  boost_root,
 								   const std::optional<String_t>&         root_module,
-								   const std::vector<String_t>&           exclude = {} );
+								   const std::vector<String_t>&           exclude = {},
+								   boostdep::AnalysisStats*               stats   = nullptr );
 
-void update_derived_information( modules_data& modules );
+// module name -> module has a CMakeLists.txt
+using CMakeStatus = std::map<String_t, bool>;
+
+CMakeStatus find_cmake_status( const std::filesystem::path& boost_root, const std::vector<String_t>& modules );
+
+// Same as above, but on a FileGraph (whose includes are already resolved). This is what the app uses, so switching
+// the root module doesn't have to resolve the include strings again.
+// Modules that are part of cmake_status (e.g. from a snapshot) are not looked up in the file system
+modules_data generate_file_list( const boostdep::FileGraph&   files,
+								 std::filesystem::path        boost_root,
+								 String_t                     root_module,
+								 const std::vector<String_t>& exclude      = {},
+								 boostdep::AnalysisStats*     stats        = nullptr,
+								 const CMakeStatus*           cmake_status = nullptr );
+
+modules_data generate_module_list( const boostdep::FileGraph&     files,
+								   std::filesystem::path          boost_root,
+								   const std::optional<String_t>& root_module,
+								   const std::vector<String_t>&   exclude      = {},
+								   boostdep::AnalysisStats*       stats        = nullptr,
+								   const CMakeStatus*             cmake_status = nullptr );
+
+void update_derived_information( modules_data& modules, boostdep::AnalysisStats* stats = nullptr );
 
 std::vector<const ModuleInfo*> get_modules_sorted_by_dep_count( const modules_data& modules );
 
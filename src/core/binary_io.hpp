@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace mdev {
+
+// The on-disk layout shared by FileGraph and ScanSnapshot:
+// Every array is written as element count (uint64) followed by the elements, padded to a multiple of 8 bytes.
+// So as long as the header size is a multiple of 8, all arrays are properly aligned in the file
+constexpr std::size_t binary_alignment = 8;
+
+inline std::size_t binary_padding( std::size_t size )
+{
+	return ( binary_alignment - size % binary_alignment ) % binary_alignment;
+}
+
+template<class T>
+void write_array( std::ostream& os, const std::vector<T>& data )
+{
+	static_assert( alignof( T ) <= binary_alignment );
+
+	const auto cnt   = static_cast<std::uint64_t>( data.size() );
+	const auto bytes = data.size() * sizeof( T );
+	const char zeros[binary_alignment]{};
+	os.write( reinterpret_cast<const char*>( &cnt ), sizeof( cnt ) );
+	os.write( reinterpret_cast<const char*>( data.data() ), bytes );
+	os.write( zeros, binary_padding( bytes ) );
+}
+
+// Reads an array written by write_array from the front of data and removes it (including the padding).
+// Returns false if data is too short
+template<class T>
+bool read_array( std::string_view& data, std::vector<T>& out )
+{
+	std::uint64_t cnt = 0;
+	if( data.size() < sizeof( cnt ) ) {
+		return false;
+	}
+	std::memcpy( &cnt, data.data(), sizeof( cnt ) );
+	data.remove_prefix( sizeof( cnt ) );
+
+	if( cnt > data.size() / sizeof( T ) ) {
+		return false;
+	}
+	const auto bytes = cnt * sizeof( T );
+	if( bytes + binary_padding( bytes ) > data.size() ) {
+		return false;
+	}
+	out.resize( cnt );
+	std::memcpy( out.data(), data.data(), bytes );
+	data.remove_prefix( bytes + binary_padding( bytes ) );
+	return true;
+}
+
+} // namespace mdev
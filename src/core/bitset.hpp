@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace mdev {
+
+// std::bitset with a size chosen at runtime (e.g. one bit per file or module)
+class DynamicBitset {
+public:
+	DynamicBitset() = default;
+	explicit DynamicBitset( std::size_t size )
+		: _size( size )
+		, _words( ( size + 63 ) / 64, 0 )
+	{
+	}
+
+	std::size_t size() const { return _size; }
+
+	bool test( std::size_t i ) const { return ( _words[i / 64] >> ( i % 64 ) ) & 1u; }
+	void set( std::size_t i ) { _words[i / 64] |= bit( i ); }
+
+	// returns the previous value
+	bool test_and_set( std::size_t i )
+	{
+		auto&      word = _words[i / 64];
+		const bool was  = ( word & bit( i ) ) != 0;
+		word |= bit( i );
+		return was;
+	}
+
+	// both sets have to have the same size. Returns true if any bit changed
+	bool merge( const DynamicBitset& other )
+	{
+		std::uint64_t changed = 0;
+		for( std::size_t i = 0; i < _words.size(); ++i ) {
+			changed |= other._words[i] & ~_words[i];
+			_words[i] |= other._words[i];
+		}
+		return changed != 0;
+	}
+
+	std::size_t count() const
+	{
+		std::size_t cnt = 0;
+		for( const auto word : _words ) {
+#ifdef _MSC_VER
+			cnt += static_cast<std::size_t>( __popcnt64( word ) );
+#else
+			cnt += static_cast<std::size_t>( __builtin_popcountll( word ) );
+#endif
+		}
+		return cnt;
+	}
+
+	// calls f( i ) for every set bit i (in ascending order)
+	template<class F>
+	void for_each( F&& f ) const
+	{
+		for( std::size_t w = 0; w < _words.size(); ++w ) {
+			for( auto word = _words[w]; word != 0; word &= word - 1 ) {
+				f( w * 64 + count_trailing_zeros( word ) );
+			}
+		}
+	}
+
+	friend bool operator==( const DynamicBitset& l, const DynamicBitset& r )
+	{
+		return l._size == r._size && l._words == r._words;
+	}
+	friend bool operator!=( const DynamicBitset& l, const DynamicBitset& r ) { return !( l == r ); }
+
+private:
+	static std::uint64_t bit( std::size_t i ) { return std::uint64_t{1} << ( i % 64 ); }
+
+	static std::size_t count_trailing_zeros( std::uint64_t word )
+	{
+#ifdef _MSC_VER
+		unsigned long idx;
+		_BitScanForward64( &idx, word );
+		return idx;
+#else
+		return static_cast<std::size_t>( __builtin_ctzll( word ) );
+#endif
+	}
+
+	std::size_t                _size = 0;
+	std::vector<std::uint64_t> _words;
+};
+
+} // namespace mdev
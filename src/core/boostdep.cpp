@@ -1,33 +1,36 @@
 #include "boostdep.hpp"
 
+#include "content_dedup.hpp"
+#include "dependency_maps.hpp"
+#include "directory_walker.hpp"
+#include "file_classifier.hpp"
+#include "file_index.hpp"
+#include "git_repository.hpp"
+#include "mapped_file.hpp"
+#include "scan_cache.hpp"
+#include "string_pool.hpp"
+#include "task_scheduler.hpp"
+#include "uring_reader.hpp"
 #include "utils.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <climits>
+#include <cstdint>
+#include <exception>
 #include <fstream>
+#include <mutex>
+#include <optional>
 #include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-#include <iostream>
-
-//#define BDG_DONT_USE_STD_PARALLEL
-
-// clang-format off
-#ifndef BDG_DONT_USE_STD_PARALLEL
-	#ifndef __cpp_lib_parallel_algorithm
-		#define BDG_DONT_USE_STD_PARALLEL
-	#endif
-#endif // !BDG_DONT_USE_STD_PARALLE
-
-
-#ifndef BDG_DONT_USE_STD_PARALLEL
-	#include <execution>
-	#include <mutex>
-#endif //
-
-// clang-format on
-
 namespace fs = std::filesystem;
 
 namespace mdev::boostdep {
@@ -62,6 +65,58 @@ auto find_modules( fs::path const& path, String_t prefix = "" ) -> std::map<Stri
 
 //################### Parse includes #####################################
 
+using Clock = std::chrono::steady_clock;
+
+// Every scan thread has its own counters (if stats were requested), so no synchronization is necessary
+struct ScanCounters {
+	std::chrono::nanoseconds     walk_time{0};
+	std::uint64_t                bytes_read = 0;
+	std::uint64_t                lines      = 0;
+	std::uint64_t                candidates = 0;
+	std::uint64_t                hits       = 0;
+	std::vector<ModuleScanStats> modules; // by module index
+};
+
+thread_local ScanCounters* current_counters = nullptr;
+
+// Makes the parser functions below count into counters, as long as the scope lives
+class CountersScope {
+public:
+	explicit CountersScope( ScanCounters* counters )
+		: _prev( std::exchange( current_counters, counters ) )
+	{
+	}
+	CountersScope( const CountersScope& ) = delete;
+	CountersScope& operator=( const CountersScope& ) = delete;
+	~CountersScope() { current_counters = _prev; }
+
+private:
+	ScanCounters* _prev;
+};
+
+ScanCounters* get_counters( std::vector<ScanCounters>& counters, std::size_t thread )
+{
+	return counters.empty() ? nullptr : &counters[thread];
+}
+
+// Adds the time since start to the given module of the current thread
+void add_module_time( std::size_t module_index, std::size_t files, Clock::time_point start )
+{
+	if( current_counters ) {
+		auto& m = current_counters->modules[module_index];
+		m.files += files;
+		m.time += Clock::now() - start;
+	}
+}
+
+void add_walk_time( Clock::time_point start )
+{
+	if( current_counters ) {
+		current_counters->walk_time += Clock::now() - start;
+	}
+}
+
+
 std::string_view trim_left( std::string_view str )
 {
 	auto i = str.find_first_not_of( " \t" );
@@ -109,7 +164,8 @@ std::string_view strip_quotes( std::string_view str )
 	return str.substr( 1, k - 1 );
 }
 
-std::string_view get_included_file_from_line( std::string_view str )
+// min_size: includes (with the quotes) shorter than this are ignored
+std::string_view get_included_file_from_line( std::string_view str, std::size_t min_size )
 {
 	//                                   str=   #  include <boost/foo/bar/baz.h>
 	str = trim_left_with( str, '#' ); // str=include <boost/foo/bar/baz.hpp>
@@ -118,7 +174,7 @@ std::string_view get_included_file_from_line( std::string_view str )
 	str = trim_prefix( str, "include" ); // str= <boost/foo/bar/baz.hpp>
 	str = trim_left( str );              // str=<boost/foo/bar/baz.hpp>
 
-	if( str.size() < 13 ) return {}; // this can't be a boost header if only 13 chars remain <boost/a.hpp>
+	if( str.size() < min_size ) return {}; // e.g. <boost/a.hpp> is the shortest possible boost include
 
 	return strip_quotes( str ); // str=boost/foo/bar/baz.h
 }
@@ -145,11 +201,57 @@ std::string_view get_included_file_from_line( std::string_view str, bool& ignore
 }
 #endif
 
-std::vector<String_t> get_included_boost_headers( fs::path const& file )
+// returns the included boost header (e.g. boost/foo/bar.hpp) or an empty string_view
+std::string_view get_included_boost_header( std::string_view line, const IncludeMatcher& matcher )
 {
+	if( line.size() < matcher.min_line_size() ) {
+		return {}; // this can't be an include of a boost library
+	}
+
+	auto str = get_included_file_from_line( line, matcher.min_include_size() );
+	if( str == std::string_view{} || !matcher.matches( str ) ) {
+		return {};
+	}
+	return str;
+}
+
+const IncludeMatcher& get_include_matcher( const ScanOptions& options )
+{
+	return options.include_matcher ? *options.include_matcher : IncludeMatcher::boost();
+}
+
+// Classification by name only, files with FileClass::Unknown get sniffed once their content is read anyway
+FileClass classify( const ScanOptions& options, std::string_view path )
+{
+	return options.classifier ? options.classifier->classify( path ) : FileClass::Source;
+}
+
+bool is_skipped_content( const ScanOptions& options, bool sniff, std::string_view content )
+{
+	return sniff && options.classifier->is_skipped_content( content );
+}
+
+// Headers included by a file or nullopt, if the content of a sniffed file says it should be skipped
+using ScanResult = std::optional<std::vector<String_t>>;
+
+ScanResult get_included_boost_headers_stream( fs::path const& file, const ScanOptions& options, bool sniff )
+{
+	const auto& matcher = get_include_matcher( options );
+
 	std::vector<String_t> headers;
 	std::ifstream            is( file );
 
+	if( sniff ) {
+		String_t head( options.classifier->sniff_size, '\0' );
+		is.read( head.data(), static_cast<std::streamsize>( head.size() ) );
+		head.resize( static_cast<std::size_t>( is.gcount() ) );
+		if( is_skipped_content( options, sniff, head ) ) {
+			return std::nullopt;
+		}
+		is.clear();
+		is.seekg( 0 );
+	}
+
 	// Note: std::getline is the major performance bottleneck during scanning
 	//
 	// using fopen + fgets + fixed buffer, seems to reduce scan time by ~10-20%
@@ -157,25 +259,171 @@ std::vector<String_t> get_included_boost_headers( fs::path const& file )
 	// I prefer the simpler c++ code for now
 
 	for( std::string line; std::getline( is, line ); ) {
-		if( line.size() < 20 ) {
-			continue; // this can't be an include of a boost library
+		auto str = get_included_boost_header( line, matcher );
+		if( !str.empty() ) {
+			headers.emplace_back( str );
 		}
+		if( current_counters ) {
+			current_counters->bytes_read += line.size() + 1;
+			current_counters->lines++;
+			current_counters->candidates++; // every line is a candidate here
+		}
+	}
+	if( current_counters ) {
+		current_counters->hits += headers.size();
+	}
+	return headers;
+}
 
-		auto str = get_included_file_from_line( line );
-		if( str == std::string_view{} || str.substr( 0, 6 ) != "boost/" ) {
-			continue;
+// Only parses content that wasn't seen before (if deduplication is enabled)
+std::vector<String_t> parse_content( std::string_view content, const ScanOptions& options )
+{
+	if( current_counters ) {
+		current_counters->bytes_read += content.size();
+	}
+	const auto& matcher = get_include_matcher( options );
+	if( options.dedup == nullptr ) {
+		return parse_included_boost_headers( content, PrefilterKernel::Auto, matcher );
+	}
+
+	const auto key = ContentDedupTable::make_key( content );
+	if( auto known = options.dedup->lookup( key ) ) {
+		return std::move( *known );
+	}
+	auto headers = parse_included_boost_headers( content, PrefilterKernel::Auto, matcher );
+	options.dedup->store( key, headers );
+	return headers;
+}
+
+ScanResult get_included_boost_headers_mapped( fs::path const& file, const ScanOptions& options, bool sniff )
+{
+	const MappedFile mapping( file );
+	if( is_skipped_content( options, sniff, mapping.content() ) ) {
+		return std::nullopt;
+	}
+	return parse_content( mapping.content(), options );
+}
+
+ScanResult read_included_boost_headers( fs::path const& file, const ScanOptions& options, bool sniff )
+{
+	switch( options.read_method ) {
+		case ReadMethod::Stream: return get_included_boost_headers_stream( file, options, sniff );
+		case ReadMethod::MemoryMap: return get_included_boost_headers_mapped( file, options, sniff );
+		// not worth it for a single file
+		case ReadMethod::IoUring: return get_included_boost_headers_mapped( file, options, sniff );
+	}
+	return std::vector<String_t>{};
+}
+
+// Only files that were parsed end up in the cache, so a cache hit never needs sniffing
+ScanResult get_included_boost_headers( fs::path const& file, const ScanOptions& options, bool sniff )
+{
+	if( options.cache == nullptr ) {
+		return read_included_boost_headers( file, options, sniff );
+	}
+
+	const auto key   = file.generic_string();
+	const auto stamp = get_file_stamp( file );
+	if( stamp ) {
+		if( auto cached = options.cache->lookup( key, *stamp ) ) {
+			return std::move( *cached );
 		}
-		headers.emplace_back( str );
+	}
+
+	auto headers = read_included_boost_headers( file, options, sniff );
+	if( stamp && headers ) {
+		options.cache->store( key, *stamp, *headers );
 	}
 	return headers;
 }
 
+} // namespace
+
+std::vector<String_t> get_included_boost_headers( fs::path const& file, const ScanOptions& options )
+{
+	return *get_included_boost_headers( file, options, false );
+}
+
+namespace {
+
+// Every worker thread keeps its own ring around
+UringReader& get_uring_reader()
+{
+	thread_local UringReader reader;
+	return reader;
+}
+
+struct FileToScan {
+	fs::path path;
+	bool     sniff = false; // FileClass::Unknown
+};
+
+// Same as calling get_included_boost_headers for each file, but the files may be read concurrently
+std::vector<ScanResult> get_included_boost_headers( const std::vector<FileToScan>& files, const ScanOptions& options )
+{
+	std::vector<ScanResult> ret( files.size() );
+	if( options.read_method != ReadMethod::IoUring ) {
+		for( std::size_t i = 0; i < files.size(); ++i ) {
+			ret[i] = get_included_boost_headers( files[i].path, options, files[i].sniff );
+		}
+		return ret;
+	}
+
+	struct CacheKey {
+		String_t                 path;
+		std::optional<FileStamp> stamp;
+	};
+	std::vector<CacheKey>    keys;
+	std::vector<fs::path>    to_read;
+	std::vector<std::size_t> to_read_idx;
+	if( options.cache ) {
+		keys.resize( files.size() );
+		for( std::size_t i = 0; i < files.size(); ++i ) {
+			keys[i] = {files[i].path.generic_string(), get_file_stamp( files[i].path )};
+			if( keys[i].stamp ) {
+				if( auto cached = options.cache->lookup( keys[i].path, *keys[i].stamp ) ) {
+					ret[i] = std::move( *cached );
+					continue;
+				}
+			}
+			to_read.push_back( files[i].path );
+			to_read_idx.push_back( i );
+		}
+	} else {
+		for( std::size_t i = 0; i < files.size(); ++i ) {
+			to_read.push_back( files[i].path );
+			to_read_idx.push_back( i );
+		}
+	}
+
+	get_uring_reader().read_files( to_read, [&]( std::size_t idx, std::string_view content ) {
+		const auto i = to_read_idx[idx];
+		if( is_skipped_content( options, files[i].sniff, content ) ) {
+			return;
+		}
+		ret[i] = parse_content( content, options );
+		if( options.cache && keys[i].stamp ) {
+			options.cache->store( keys[i].path, *keys[i].stamp, *ret[i] );
+		}
+	} );
+	return ret;
+}
+
+// Every thread keeps its own buffers around
+DirectoryWalker& get_directory_walker()
+{
+	thread_local DirectoryWalker walker;
+	return walker;
+}
+
 /**
  * dir:  directory to search,
  * prefix: Filnames will be given relative to this director MUST BE A PARENT OF dir!
  */
-std::vector<FileInfo>
-scan_files_in_directory( fs::path const& dir, fs::path const& prefix, FileInfo base_template = {} )
+std::vector<FileInfo> scan_files_in_directory( fs::path const&    dir,
+											   fs::path const&    prefix,
+											   const ScanOptions& options,
+											   FileInfo           base_template = {} )
 {
 	std::vector<FileInfo> discovered_files;
 	if( !fs::exists( dir ) ) {
@@ -183,197 +431,1233 @@ scan_files_in_directory( fs::path const& dir, fs::path const& prefix, FileInfo b
 	}
 
 	const auto prefix_size = prefix.generic_string().size();
-	for( auto& entry : fs::recursive_directory_iterator( dir ) ) {
-		if( entry.is_regular_file() ) {
-			FileInfo f = base_template;
+	get_directory_walker().walk( dir, [&]( std::string_view path ) {
+		const auto file_class = classify( options, path );
+		if( file_class == FileClass::Skipped ) {
+			return;
+		}
+		auto headers = get_included_boost_headers( fs::path( path ), options, file_class == FileClass::Unknown );
+		if( !headers ) {
+			return;
+		}
+		FileInfo f = base_template;
 
-			// fs::relative would be the "obvious" thing to do here, but it is much slower (at least on windows)
-			f.name           = String_t{entry.path().generic_string()}.substr( prefix_size + 1 );
-			f.included_files = get_included_boost_headers( entry.path() );
+		// fs::relative would be the "obvious" thing to do here, but it is much slower (at least on windows)
+		f.name           = String_t{path.substr( prefix_size + 1 )};
+		f.included_files = std::move( *headers );
 
-			discovered_files.push_back( std::move( f ) );
-		}
-	}
+		discovered_files.push_back( std::move( f ) );
+	} );
 	return discovered_files;
 }
 
-std::vector<FileInfo> scan_module_files( const fs::path&   module_root,
-										 std::string_view  module_name,
-										 TrackSources      track_sources,
-										 TrackTests        track_tests )
+struct ScanRoot {
+	fs::path    dir;
+	fs::path    prefix; // filenames are relative to this directory
+	FileInfo    base_template;
+	std::size_t module_index = 0; // position of the module in the (sorted) module list
+};
+
+std::vector<ScanRoot>
+get_scan_roots( const fs::path& module_root, std::string_view module_name, const ScanOptions& options )
 {
 	FileInfo base_template;
-	base_template.module_name = String_t(module_name);
+	base_template.module_name = String_t( module_name );
 
-	std::vector<FileInfo> ret;
+	std::vector<ScanRoot> ret;
+
+	base_template.category = FileCategory::Header;
+	ret.push_back( {module_root / "include", module_root / "include", base_template} );
+
+	if( options.track_sources == TrackSources::Yes ) {
+		base_template.category = FileCategory::Source;
+		// filenames of source code file include module itself
+		ret.push_back( {module_root / "src", module_root.parent_path(), base_template} );
+	}
+
+	if( options.track_tests == TrackTests::Yes ) {
+		base_template.category = FileCategory::Test;
+		ret.push_back( {module_root / "test", module_root.parent_path(), base_template} );
+	}
+
+	return ret;
+}
+
+std::vector<ScanRoot> get_all_scan_roots( const fs::path& boost_root, const ScanOptions& options )
+{
+	std::vector<ScanRoot> roots;
+	std::size_t           module_index = 0;
+	for( const auto& [name, path] : find_modules( boost_root / "libs" ) ) {
+		auto module_roots = get_scan_roots( path, name, options );
+		for( auto& r : module_roots ) {
+			r.module_index = module_index;
+		}
+		merge_into( std::move( module_roots ), roots );
+		module_index++;
+	}
+	return roots;
+}
+
+//################### Scheduling #####################################
+
+// Small enough to balance the load between threads, big enough to keep the scheduling overhead low
+constexpr std::size_t files_per_task = 16;
+
+// io_uring only helps if there are enough reads in flight
+constexpr std::size_t uring_files_per_task = 128;
+
+std::size_t get_files_per_task( const ScanOptions& options )
+{
+	return options.read_method == ReadMethod::IoUring && UringReader::is_supported() ? uring_files_per_task
+																					  : files_per_task;
+}
+
+template<class Record>
+struct ScanContext {
+	ScanContext( TaskScheduler& scheduler, const ScanOptions& options, StringPool* pool = nullptr )
+		: scheduler( scheduler )
+		, options( options )
+		, pool( pool )
 	{
-		base_template.category = FileCategory::Header;
+	}
+
+	TaskScheduler&     scheduler;
+	const ScanOptions& options;
+	StringPool*        pool; // only used for InternedFileInfo
+
+	std::atomic<std::size_t> skipped_files{0};
+
+	// results[worker][module_index]: Every worker has its own buffers, so no synchronization is necessary
+	// and the final result is already grouped by module
+	std::vector<std::vector<std::vector<Record>>> results;
 
-		auto files = scan_files_in_directory( module_root / "include", module_root / "include", base_template );
+	std::vector<ScanCounters> counters; // per worker, empty if nobody is interested in stats
+};
+
+std::vector<ScanCounters> make_counters( const ScanStats* stats, std::size_t threads, std::size_t module_cnt )
+{
+	ScanCounters proto;
+	proto.modules.resize( module_cnt );
+	return std::vector<ScanCounters>( stats ? threads : 0, proto );
+}
 
-		mdev::merge_into( std::move( files ), ret );
+// Sums up the counters of all threads
+template<class Root>
+void merge_counters( ScanStats& stats, const std::vector<ScanCounters>& counters, const std::vector<Root>& roots )
+{
+	stats.modules.clear();
+	for( const auto& root : roots ) {
+		if( root.module_index >= stats.modules.size() ) {
+			stats.modules.resize( root.module_index + 1 );
+		}
+		stats.modules[root.module_index].name = root.base_template.module_name;
 	}
 
-	if( track_sources == TrackSources::Yes ) {
+	for( const auto& c : counters ) {
+		stats.walk_time += c.walk_time;
+		stats.bytes_read += c.bytes_read;
+		stats.lines_inspected += c.lines;
+		stats.include_candidates += c.candidates;
+		stats.include_hits += c.hits;
+		for( std::size_t m = 0; m < c.modules.size() && m < stats.modules.size(); ++m ) {
+			stats.modules[m].files += c.modules[m].files;
+			stats.modules[m].time += c.modules[m].time;
+		}
+	}
+}
 
-		base_template.category = FileCategory::Source;
+// Appends the record for file (its name is relative to the prefix of root)
+void add_record( std::vector<FileInfo>&  infos,
+				 const ScanRoot&         root,
+				 std::size_t             prefix_size,
+				 const fs::path&         file,
+				 std::vector<String_t>&& headers,
+				 StringPool* )
+{
+	FileInfo f       = root.base_template;
+	f.name           = String_t{file.generic_string()}.substr( prefix_size + 1 );
+	f.included_files = std::move( headers );
+	infos.push_back( std::move( f ) );
+}
 
-		// filenames of source code file include module itself
-		auto files = scan_files_in_directory( module_root / "src", module_root.parent_path(), base_template );
+void add_record( std::vector<InternedFileInfo>& infos,
+				 const ScanRoot&                root,
+				 std::size_t                    prefix_size,
+				 const fs::path&                file,
+				 std::vector<String_t>&&        headers,
+				 StringPool*                    pool )
+{
+	InternedFileInfo f;
+	f.name        = pool->intern( std::string_view{file.generic_string()}.substr( prefix_size + 1 ) );
+	f.module_name = pool->intern( root.base_template.module_name );
+	f.category    = root.base_template.category;
+	f.included_files.reserve( headers.size() );
+	for( const auto& header : headers ) {
+		f.included_files.push_back( pool->intern( header ) );
+	}
+	infos.push_back( std::move( f ) );
+}
 
-		mdev::merge_into( std::move( files ), ret );
+template<class Record>
+void scan_files( ScanContext<Record>&           ctx,
+				 const ScanRoot&                root,
+				 std::size_t                    prefix_size,
+				 const std::vector<FileToScan>& files,
+				 std::size_t                    worker )
+{
+	if( files.empty() ) {
+		return;
 	}
 
-	if( track_tests == TrackTests::Yes ) {
-		base_template.category = FileCategory::Test;
+	CountersScope counters( get_counters( ctx.counters, worker ) );
+	const auto    start = Clock::now();
 
-		auto files = scan_files_in_directory( module_root / "test", module_root.parent_path(), base_template );
+	auto&       infos   = ctx.results[worker][root.module_index];
+	auto        headers = get_included_boost_headers( files, ctx.options );
+	std::size_t scanned = 0;
+	for( std::size_t i = 0; i < files.size(); ++i ) {
+		if( !headers[i] ) {
+			ctx.skipped_files++;
+			continue;
+		}
+		add_record( infos, root, prefix_size, files[i].path, std::move( *headers[i] ), ctx.pool );
+		scanned++;
+	}
+	add_module_time( root.module_index, scanned, start );
+}
 
-		mdev::merge_into( std::move( files ), ret );
+// Subdirectories and batches of files become separate tasks, so huge modules get spread across all threads
+template<class Record>
+void scan_directory( ScanContext<Record>& ctx,
+					 const ScanRoot&      root,
+					 std::size_t          prefix_size,
+					 const fs::path&      dir,
+					 std::size_t          worker )
+{
+	const auto              batch_size = get_files_per_task( ctx.options );
+	std::vector<FileToScan> batch;
+
+	CountersScope counters( get_counters( ctx.counters, worker ) );
+	const auto    start = Clock::now();
+	get_directory_walker().list(
+		dir,
+		[&]( std::string_view file ) {
+			const auto file_class = classify( ctx.options, file );
+			if( file_class == FileClass::Skipped ) {
+				ctx.skipped_files++;
+				return;
+			}
+			batch.push_back( {fs::path( file ), file_class == FileClass::Unknown} );
+			if( batch.size() == batch_size ) {
+				ctx.scheduler.spawn( [&ctx, &root, prefix_size, files = std::move( batch )]( std::size_t w ) {
+					scan_files( ctx, root, prefix_size, files, w );
+				} );
+				batch.clear();
+			}
+		},
+		[&]( std::string_view sub_dir ) {
+			ctx.scheduler.spawn( [&ctx, &root, prefix_size, sub_dir = fs::path( sub_dir )]( std::size_t w ) {
+				scan_directory( ctx, root, prefix_size, sub_dir, w );
+			} );
+		} );
+	add_walk_time( start );
+	scan_files( ctx, root, prefix_size, batch, worker );
+}
+
+// Concatenates the per worker results in module order
+template<class Record>
+std::vector<Record> collect_results( std::vector<std::vector<std::vector<Record>>>& results, std::size_t module_cnt )
+{
+	std::size_t total = 0;
+	for( const auto& worker_results : results ) {
+		for( const auto& files : worker_results ) {
+			total += files.size();
+		}
 	}
 
+	std::vector<Record> ret;
+	ret.reserve( total );
+	for( std::size_t m = 0; m < module_cnt; ++m ) {
+		for( auto& worker_results : results ) {
+			merge_into( std::move( worker_results[m] ), ret );
+		}
+	}
 	return ret;
 }
 
-} // namespace
+//################### Pipeline #####################################
 
-std::vector<FileInfo>
-scan_all_boost_modules( const fs::path& boost_root, const TrackSources track_sources, const TrackTests track_tests )
+struct PipelineItem {
+	const ScanRoot*                      root        = nullptr;
+	std::size_t                          prefix_size = 0;
+	fs::path                             path;
+	String_t                             content; // filled by the readers
+	std::optional<FileStamp>             stamp;
+	std::optional<std::vector<String_t>> headers; // already known from the scan cache, nothing to read or parse
+	bool                                 sniff = false; // the classifier has to look at the content
+};
+
+// Reads the whole file into content
+void read_file( const fs::path& file, String_t& content )
 {
-	const auto modules = find_modules( boost_root / "libs" );
+	content.clear();
+	std::ifstream in( file, std::ios::binary );
+	if( !in ) {
+		return;
+	}
+	in.seekg( 0, std::ios::end );
+	const auto size = in.tellg();
+	if( size <= 0 ) {
+		return;
+	}
+	in.seekg( 0, std::ios::beg );
+	content.resize( static_cast<std::size_t>( size ) );
+	in.read( content.data(), size );
+	content.resize( static_cast<std::size_t>( in.gcount() ) );
+}
 
-	std::vector<FileInfo> module_infos;
-	module_infos.reserve( modules.size() );
-	// NOTE: In principle this is a classic map_reduce problem,
-	// but my atempt in using std::transform_reduce ended in slower and more complicated code
+// Per stage bookkeeping. Exceptions are remembered (and rethrown at the end) instead of stopping the thread,
+// so the other stages never wait for a queue that is never going to be drained.
+struct PipelineStage {
+	StageStats               stats;
+	std::atomic<std::size_t> running{0};
+	std::atomic<std::size_t> items{0};
+	std::atomic<long long>   busy_ns{0};
 
-#ifndef BDG_DONT_USE_STD_PARALLEL
-	std::mutex mx;
-#endif
-	std::for_each( //
-#ifndef BDG_DONT_USE_STD_PARALLEL
-		std::execution::par, //
-#endif
-		modules.begin(), //
-		modules.end(),   //
-		[&]( const auto& m ) {
-			auto ret = scan_module_files( m.second, m.first, track_sources, track_tests );
-#ifndef BDG_DONT_USE_STD_PARALLEL
-			std::lock_guard lg( mx );
-#endif
-			merge_into( std::move( ret ), module_infos );
-		} //
-	);
-	std::sort( module_infos.begin(), //
-			   module_infos.end(),   //
-			   []( const auto& l, const auto& r ) { return l.module_name < r.module_name; } );
-	return module_infos;
+	void add_busy( Clock::duration d )
+	{
+		busy_ns.fetch_add( std::chrono::duration_cast<std::chrono::nanoseconds>( d ).count(),
+						   std::memory_order_relaxed );
+	}
+};
+
+class PipelineErrors {
+public:
+	void store( std::exception_ptr e )
+	{
+		std::scoped_lock lock( _mx );
+		if( !_error ) {
+			_error = std::move( e );
+		}
+	}
+	void rethrow()
+	{
+		if( _error ) {
+			std::rethrow_exception( _error );
+		}
+	}
+
+private:
+	std::mutex         _mx;
+	std::exception_ptr _error;
+};
+
+template<class Record>
+std::vector<Record> scan_pipeline( const std::vector<ScanRoot>& roots,
+								   std::size_t                  module_cnt,
+								   const ScanOptions&           options,
+								   ScanStats*                   stats,
+								   StringPool*                  pool )
+{
+	const auto& config        = options.pipeline;
+	const auto  default_count = options.thread_count == 0 ? std::max( 1u, std::thread::hardware_concurrency() )
+														  : options.thread_count;
+
+	PipelineStage walk, read, parse;
+	walk.stats.name     = "walk";
+	walk.stats.threads  = std::max<std::size_t>( 1, config.walker_threads );
+	read.stats.name     = "read";
+	read.stats.threads  = std::max<std::size_t>( 1, config.reader_threads );
+	parse.stats.name    = "parse";
+	parse.stats.threads = config.parser_threads == 0 ? default_count : config.parser_threads;
+
+	BoundedQueue<PipelineItem> to_read( config.queue_capacity );
+	BoundedQueue<PipelineItem> to_parse( config.queue_capacity );
+	PipelineErrors             errors;
+
+	std::atomic<std::size_t> next_root{0};
+	std::atomic<std::size_t> skipped_files{0};
+
+	// parsers first, then readers
+	auto counters = make_counters( stats, parse.stats.threads + read.stats.threads, module_cnt );
+
+	// every walker takes whole scan roots, the files are what gets distributed across the other stages
+	const auto walker = [&] {
+		auto start = Clock::now();
+		for( auto r = next_root++; r < roots.size(); r = next_root++ ) {
+			const auto& root = roots[r];
+			try {
+				if( !fs::exists( root.dir ) ) {
+					continue;
+				}
+				const auto prefix_size = root.prefix.generic_string().size();
+				get_directory_walker().walk( root.dir, [&]( std::string_view path ) {
+					const auto file_class = classify( options, path );
+					if( file_class == FileClass::Skipped ) {
+						skipped_files++;
+						return;
+					}
+					PipelineItem item;
+					item.root        = &root;
+					item.prefix_size = prefix_size;
+					item.path        = path;
+					item.sniff       = file_class == FileClass::Unknown;
+					walk.items++;
+					walk.add_busy( Clock::now() - start );
+					to_read.push( std::move( item ) );
+					start = Clock::now();
+				} );
+			} catch( ... ) {
+				errors.store( std::current_exception() );
+			}
+		}
+		walk.add_busy( Clock::now() - start );
+		if( --walk.running == 0 ) {
+			to_read.close();
+		}
+	};
+
+	const auto reader = [&]( std::size_t idx ) {
+		CountersScope scope( get_counters( counters, parse.stats.threads + idx ) );
+		PipelineItem  item;
+		while( to_read.pop( item ) ) {
+			const auto start = Clock::now();
+			try {
+				if( options.cache ) {
+					item.stamp = get_file_stamp( item.path );
+					if( item.stamp ) {
+						item.headers = options.cache->lookup( item.path.generic_string(), *item.stamp );
+					}
+				}
+				if( !item.headers ) {
+					read_file( item.path, item.content );
+					if( is_skipped_content( options, item.sniff, item.content ) ) {
+						skipped_files++;
+						read.add_busy( Clock::now() - start );
+						continue;
+					}
+				}
+				read.items++;
+				read.add_busy( Clock::now() - start );
+				add_module_time( item.root->module_index, 0, start );
+				to_parse.push( std::move( item ) );
+			} catch( ... ) {
+				errors.store( std::current_exception() );
+			}
+		}
+		if( --read.running == 0 ) {
+			to_parse.close();
+		}
+	};
+
+	// results[parser][module_index], just like the work stealing scan
+	std::vector<std::vector<std::vector<Record>>> results(
+		parse.stats.threads, std::vector<std::vector<Record>>( module_cnt ) );
+	const auto parser = [&]( std::size_t idx ) {
+		CountersScope scope( get_counters( counters, idx ) );
+		PipelineItem  item;
+		while( to_parse.pop( item ) ) {
+			const auto start = Clock::now();
+			try {
+				auto headers = std::move( item.headers );
+				if( !headers ) {
+					headers = parse_content( item.content, options );
+					if( options.cache && item.stamp ) {
+						options.cache->store( item.path.generic_string(), *item.stamp, *headers );
+					}
+				}
+				add_record( results[idx][item.root->module_index],
+							*item.root,
+							item.prefix_size,
+							item.path,
+							std::move( *headers ),
+							pool );
+				parse.items++;
+				add_module_time( item.root->module_index, 1, start );
+			} catch( ... ) {
+				errors.store( std::current_exception() );
+			}
+			parse.add_busy( Clock::now() - start );
+		}
+	};
+
+	walk.running  = walk.stats.threads;
+	read.running  = read.stats.threads;
+	parse.running = parse.stats.threads;
+
+	const auto               start = Clock::now();
+	std::vector<std::thread> threads;
+	for( std::size_t i = 0; i < walk.stats.threads; ++i ) {
+		threads.emplace_back( walker );
+	}
+	for( std::size_t i = 0; i < read.stats.threads; ++i ) {
+		threads.emplace_back( reader, i );
+	}
+	for( std::size_t i = 0; i < parse.stats.threads; ++i ) {
+		threads.emplace_back( parser, i );
+	}
+	for( auto& t : threads ) {
+		t.join();
+	}
+	const auto total = std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - start );
+
+	errors.rethrow();
+
+	if( stats ) {
+		read.stats.input  = to_read.stats();
+		parse.stats.input = to_parse.stats();
+		stats->stages.clear();
+		for( auto* stage : {&walk, &read, &parse} ) {
+			stage->stats.items = stage->items;
+			stage->stats.busy  = std::chrono::nanoseconds( stage->busy_ns.load() );
+			stage->stats.total = total;
+			stats->stages.push_back( stage->stats );
+		}
+		merge_counters( *stats, counters, roots );
+		stats->walk_time     = walk.stats.busy;
+		stats->skipped_files = skipped_files;
+	}
+
+	return collect_results( results, module_cnt );
 }
 
-//########################################## analysis ########################################################
+bool starts_with( std::string_view str, std::string_view prefix )
+{
+	return str.substr( 0, prefix.size() ) == prefix;
+}
 
-namespace {
+// returns true if path is dir itself or anything below dir
+bool is_in_directory( std::string_view path, std::string_view dir )
+{
+	return starts_with( path, dir ) && ( path.size() == dir.size() || path[dir.size()] == '/' );
+}
 
-constexpr auto less_by_name = []( const auto& l, const auto& r ) { return l.name < r.name; };
+//################### Scan git revision #####################################
 
-auto filter_files( std::vector<FileInfo> files, std::string_view root_module ) -> std::vector<FileInfo>
+// A directory in the git object store
+struct GitDir {
+	const git::Repository* repo = nullptr;
+	git::ObjectId          tree;
+};
+
+// The boost superproject at a given revision, including the submodules (as far as they are available locally)
+class GitTree {
+public:
+	GitTree( const fs::path& boost_root, std::string_view revision )
+		: _boost_root( boost_root )
+	{
+		const auto git_dir = git::find_git_dir( boost_root );
+		if( !git_dir ) {
+			throw std::runtime_error( boost_root.string() + " is not a git repository" );
+		}
+		_super = std::make_unique<git::Repository>( *git_dir );
+		_root  = {_super.get(), _super->get_tree( _super->resolve( revision ) )};
+
+		for( const auto& entry : entries( _root ) ) {
+			if( entry.name == ".gitmodules" && entry.is_file() ) {
+				parse_gitmodules( _super->read_object( entry.id ).data );
+			}
+		}
+	}
+
+	const GitDir& root() const { return _root; }
+
+	std::vector<git::TreeEntry> entries( const GitDir& dir ) const { return dir.repo->read_tree( dir.tree ); }
+
+	// path: relative to the superproject. Submodules that aren't available locally result in an empty optional
+	std::optional<GitDir> sub_dir( const GitDir& parent, const git::TreeEntry& entry, const String_t& path )
+	{
+		if( entry.is_tree() ) {
+			return GitDir{parent.repo, entry.id};
+		}
+		if( !entry.is_gitlink() || parent.repo != _super.get() ) {
+			return {}; // no support for nested submodules
+		}
+
+		const auto it   = _submodule_names.find( path );
+		const auto name = it != _submodule_names.end() ? it->second : path;
+
+		std::vector<fs::path> candidates{_super->git_dir() / "modules" / name, _super->git_dir() / "modules" / path};
+		if( auto dir = git::find_git_dir( _boost_root / path ) ) {
+			candidates.push_back( *dir );
+		}
+		for( const auto& git_dir : candidates ) {
+			const auto repo = open_repository( git_dir );
+			if( repo && repo->has_object( entry.id ) ) {
+				return GitDir{repo, repo->get_tree( entry.id )};
+			}
+		}
+		return {};
+	}
+
+private:
+	// [submodule "<name>"]
+	//     path = <path>
+	void parse_gitmodules( const std::string& content )
+	{
+		std::istringstream is( content );
+		String_t           name;
+		for( String_t line; std::getline( is, line ); ) {
+			auto l = trim_left( line );
+			if( starts_with( l, "[submodule \"" ) ) {
+				l    = l.substr( 12 );
+				name = String_t( l.substr( 0, l.find( '"' ) ) );
+			} else if( starts_with( l, "path" ) && !name.empty() ) {
+				l = trim_left( trim_left_with( l.substr( 4 ), '=' ) );
+				_submodule_names[String_t( l.substr( 0, l.find_last_not_of( " \t\r" ) + 1 ) )] = name;
+			}
+		}
+	}
+
+	const git::Repository* open_repository( const fs::path& git_dir )
+	{
+		auto& repo = _submodules[git_dir.generic_string()];
+		if( !repo && fs::is_directory( git_dir / "objects" ) ) {
+			repo = std::make_unique<git::Repository>( git_dir );
+		}
+		return repo.get();
+	}
+
+	fs::path                                             _boost_root;
+	std::unique_ptr<git::Repository>                     _super;
+	GitDir                                               _root;
+	std::map<String_t, String_t>                         _submodule_names; // path -> name
+	std::map<String_t, std::unique_ptr<git::Repository>> _submodules;      // git dir -> repository
+};
+
+bool contains_entry( const std::vector<git::TreeEntry>& entries, std::string_view name )
 {
-	std::sort( files.begin(), files.end(), less_by_name );
+	return std::any_of( entries.begin(), entries.end(), [name]( const auto& e ) { return e.name == name; } );
+}
+
+struct GitModule {
+	GitDir   dir;
+	String_t dir_name; // last component of the path
+};
 
-	std::set<String_t> unprocessed_files;
-	for( auto& f : files ) {
-		if( f.module_name == root_module ) {
-			unprocessed_files.insert( f.name );
+// Same logic as find_modules, but working on tree objects
+auto find_modules_in_git( GitTree& tree, const GitDir& dir, const String_t& path, String_t prefix = "" )
+	-> std::map<String_t, GitModule>
+{
+	std::map<String_t, GitModule> ret;
+
+	for( const auto& entry : tree.entries( dir ) ) {
+		const auto mpath = str_concat( path, String_t( "/" ), entry.name );
+		const auto mdir  = tree.sub_dir( dir, entry, mpath );
+		if( !mdir ) {
+			continue;
+		}
+
+		auto       mname    = str_concat( prefix, entry.name );
+		const auto children = tree.entries( *mdir );
+
+		if( contains_entry( children, "sublibs" ) ) {
+			auto r = find_modules_in_git( tree, *mdir, mpath, str_concat( mname, String_t( "~" ) ) );
+			ret.merge( r );
+		}
+
+		if( contains_entry( children, "include" ) ) {
+			ret[mname] = GitModule{*mdir, entry.name};
 		}
 	}
+	return ret;
+}
 
-	// file_name -> file_info
-	std::map<String_t, FileInfo> filtered_file_map;
-	while( unprocessed_files.size() != 0 ) {
+struct GitScanRoot {
+	GitDir      dir;
+	String_t    prefix; // prepended to the path relative to dir
+	FileInfo    base_template;
+	std::size_t module_index = 0;
+};
 
-		std::set<String_t> new_unprocessed_files;
+std::vector<GitScanRoot> get_all_git_scan_roots( GitTree& tree, const ScanOptions& options )
+{
+	std::vector<GitScanRoot> roots;
 
-		for( const auto& file : unprocessed_files ) {
-			if( filtered_file_map.count( file ) == 0 ) {
+	std::optional<GitDir> libs;
+	for( const auto& entry : tree.entries( tree.root() ) ) {
+		if( entry.name == "libs" ) {
+			libs = tree.sub_dir( tree.root(), entry, "libs" );
+		}
+	}
+	if( !libs ) {
+		return roots;
+	}
 
-				const auto& it = std::lower_bound( files.begin(), files.end(), FileInfo{file}, less_by_name );
-				if( it != files.end() && it->name == file ) {
-					filtered_file_map[file] = *it;
-					new_unprocessed_files.insert( it->included_files.begin(), it->included_files.end() );
+	std::size_t module_index = 0;
+	for( const auto& [name, module] : find_modules_in_git( tree, *libs, "libs" ) ) {
+		FileInfo base_template;
+		base_template.module_name = name;
+
+		const auto add_root = [&]( std::string_view sub_dir, FileCategory category, const String_t& prefix ) {
+			for( const auto& entry : tree.entries( module.dir ) ) {
+				if( entry.name == sub_dir && entry.is_tree() ) {
+					base_template.category = category;
+					roots.push_back( {GitDir{module.dir.repo, entry.id}, prefix, base_template, module_index} );
 				}
 			}
+		};
+
+		add_root( "include", FileCategory::Header, "" );
+		if( options.track_sources == TrackSources::Yes ) {
+			// filenames of source code file include module itself
+			add_root( "src", FileCategory::Source, module.dir_name + "/src/" );
 		}
-		std::swap( new_unprocessed_files, unprocessed_files );
+		if( options.track_tests == TrackTests::Yes ) {
+			add_root( "test", FileCategory::Test, module.dir_name + "/test/" );
+		}
+		module_index++;
 	}
+	return roots;
+}
 
-	std::vector<FileInfo> ret;
-	for( auto& [name, info] : filtered_file_map ) {
-		ret.push_back( info );
+struct GitFile {
+	String_t      name;
+	git::ObjectId blob;
+};
+
+std::vector<String_t>
+get_included_boost_headers( const git::Repository& repo, const git::ObjectId& blob, const ScanOptions& options )
+{
+	if( options.dedup == nullptr ) {
+		return parse_content( repo.read_object( blob ).data, options );
+	}
+	if( auto known = options.dedup->lookup( blob ) ) {
+		return std::move( *known );
+	}
+	auto headers = parse_content( repo.read_object( blob ).data, options );
+	options.dedup->store( blob, headers );
+	return headers;
+}
+
+void scan_git_files( ScanContext<FileInfo>&      ctx,
+					 const GitScanRoot&          root,
+					 const std::vector<GitFile>& files,
+					 std::size_t                 worker )
+{
+	CountersScope counters( get_counters( ctx.counters, worker ) );
+	const auto    start = Clock::now();
+
+	auto&      infos        = ctx.results[worker][root.module_index];
+	const auto first_record = infos.size();
+	for( const auto& file : files ) {
+		FileInfo f = root.base_template;
+		f.name     = file.name;
+
+		const auto file_class = classify( ctx.options, file.name );
+		if( file_class == FileClass::Skipped ) {
+			ctx.skipped_files++;
+			continue;
+		} else if( file_class == FileClass::Unknown ) {
+			const auto blob = root.dir.repo->read_object( file.blob );
+			if( is_skipped_content( ctx.options, true, blob.data ) ) {
+				ctx.skipped_files++;
+				continue;
+			}
+			f.included_files = parse_content( blob.data, ctx.options );
+		} else {
+			f.included_files = get_included_boost_headers( *root.dir.repo, file.blob, ctx.options );
+		}
+		infos.push_back( std::move( f ) );
+	}
+	add_module_time( root.module_index, infos.size() - first_record, start );
+}
+
+void scan_git_directory( ScanContext<FileInfo>& ctx,
+						 const GitScanRoot&     root,
+						 const GitDir&          dir,
+						 const String_t&        prefix,
+						 std::size_t            worker )
+{
+	CountersScope counters( get_counters( ctx.counters, worker ) );
+	const auto    start = Clock::now();
+
+	std::vector<GitFile> batch;
+	for( auto& entry : dir.repo->read_tree( dir.tree ) ) {
+		if( entry.is_tree() ) {
+			ctx.scheduler.spawn( [&ctx, &root, sub_dir = GitDir{dir.repo, entry.id}, sub_prefix = prefix + entry.name + "/"](
+									 std::size_t w ) { scan_git_directory( ctx, root, sub_dir, sub_prefix, w ); } );
+		} else if( entry.is_file() ) {
+			batch.push_back( {prefix + entry.name, entry.id} );
+			if( batch.size() == files_per_task ) {
+				ctx.scheduler.spawn( [&ctx, &root, files = std::move( batch )]( std::size_t w ) {
+					scan_git_files( ctx, root, files, w );
+				} );
+				batch.clear();
+			}
+		}
+	}
+	add_walk_time( start );
+	scan_git_files( ctx, root, batch, worker );
+}
+
+// Same as scanning the working tree, but all trees and blobs are read from the object store
+std::vector<FileInfo> scan_git_revision( const fs::path& boost_root, const ScanOptions& options, ScanStats* stats )
+{
+	GitTree    tree( boost_root, options.git_revision );
+	const auto roots = get_all_git_scan_roots( tree, options );
+
+	TaskScheduler scheduler( options.thread_count );
+
+	const std::size_t     module_cnt = roots.empty() ? 0 : roots.back().module_index + 1;
+	ScanContext<FileInfo> ctx( scheduler, options );
+	ctx.results.resize( scheduler.thread_count(), std::vector<std::vector<FileInfo>>( module_cnt ) );
+	ctx.counters = make_counters( stats, scheduler.thread_count(), module_cnt );
+
+	for( const auto& root : roots ) {
+		scheduler.spawn( [&ctx, &root]( std::size_t worker ) {
+			scan_git_directory( ctx, root, root.dir, root.prefix, worker );
+		} );
+	}
+
+	auto worker_stats = scheduler.run();
+	if( stats ) {
+		merge_counters( *stats, ctx.counters, roots );
+		stats->workers       = std::move( worker_stats );
+		stats->skipped_files = ctx.skipped_files;
+	}
+
+	return collect_results( ctx.results, module_cnt );
+}
+
+template<class Record>
+std::vector<Record>
+scan_modules( const fs::path& boost_root, const ScanOptions& options, ScanStats* stats, StringPool* pool )
+{
+	if( !options.git_revision.empty() ) {
+		auto files = scan_git_revision( boost_root, options, stats );
+		if constexpr( std::is_same_v<Record, FileInfo> ) {
+			return files;
+		} else {
+			return intern_files( files, *pool );
+		}
+	}
+
+	const auto roots = get_all_scan_roots( boost_root, options );
+
+	if( options.cache ) {
+		options.cache->start_scan();
+	}
+
+	const std::size_t module_cnt = roots.empty() ? 0 : roots.back().module_index + 1;
+	if( options.strategy == ScanStrategy::Pipeline ) {
+		return scan_pipeline<Record>( roots, module_cnt, options, stats, pool );
+	}
+
+	// NOTE: In principle this is a classic map_reduce problem, but parallelizing over modules
+	// leaves most cores idle at the end while the huge modules (spirit, geometry, ...) are still being scanned.
+	// So we schedule individual directories and batches of files instead.
+	TaskScheduler scheduler( options.thread_count );
+
+	ScanContext<Record> ctx( scheduler, options, pool );
+	ctx.results.resize( scheduler.thread_count(), std::vector<std::vector<Record>>( module_cnt ) );
+	ctx.counters = make_counters( stats, scheduler.thread_count(), module_cnt );
+
+	for( const auto& root : roots ) {
+		if( fs::exists( root.dir ) ) {
+			const auto prefix_size = root.prefix.generic_string().size();
+			scheduler.spawn( [&ctx, &root, prefix_size]( std::size_t worker ) {
+				scan_directory( ctx, root, prefix_size, root.dir, worker );
+			} );
+		}
+	}
+
+	auto worker_stats = scheduler.run();
+	if( stats ) {
+		merge_counters( *stats, ctx.counters, roots );
+		stats->workers       = std::move( worker_stats );
+		stats->skipped_files = ctx.skipped_files;
+	}
+
+	return collect_results( ctx.results, module_cnt );
+}
+
+template<class Record>
+std::vector<Record>
+scan_all_modules( const fs::path& boost_root, const ScanOptions& options, ScanStats* stats, StringPool* pool )
+{
+	if( stats ) {
+		*stats = {};
+	}
+
+	const auto start = Clock::now();
+	auto       files = scan_modules<Record>( boost_root, options, stats, pool );
+	if( stats ) {
+		stats->total = Clock::now() - start;
+		stats->files = files.size();
+	}
+	return files;
+}
+
+} // namespace
+
+std::map<String_t, fs::path> find_boost_modules( const fs::path& boost_root )
+{
+	return find_modules( boost_root / "libs" );
+}
+
+std::vector<String_t>
+parse_included_boost_headers( std::string_view content, PrefilterKernel kernel, const IncludeMatcher& matcher )
+{
+	// only the few lines that look like an include of a boost header have to be parsed properly
+	thread_local std::vector<std::string_view> candidates;
+	candidates.clear();
+	find_include_candidates( content, candidates, kernel, matcher );
+
+	std::vector<String_t> headers;
+	for( auto line : candidates ) {
+		auto str = get_included_boost_header( line, matcher );
+		if( !str.empty() ) {
+			headers.emplace_back( str );
+		}
+	}
+
+	if( current_counters ) {
+		// only done if somebody is interested, as this is another pass over the content
+		current_counters->lines += static_cast<std::uint64_t>( std::count( content.begin(), content.end(), '\n' ) );
+		current_counters->candidates += candidates.size();
+		current_counters->hits += headers.size();
+	}
+	return headers;
+}
+
+std::vector<FileInfo>
+scan_all_boost_modules( const fs::path& boost_root, const ScanOptions& options, ScanStats* stats )
+{
+	return scan_all_modules<FileInfo>( boost_root, options, stats, nullptr );
+}
+
+std::vector<InternedFileInfo> scan_all_boost_modules_interned( const fs::path&    boost_root,
+															   const ScanOptions& options,
+															   ScanStats*         stats,
+															   StringPool&        pool )
+{
+	return scan_all_modules<InternedFileInfo>( boost_root, options, stats, &pool );
+}
+
+std::vector<InternedFileInfo> intern_files( const std::vector<FileInfo>& files, StringPool& pool )
+{
+	std::vector<InternedFileInfo> ret;
+	ret.reserve( files.size() );
+	for( const auto& f : files ) {
+		InternedFileInfo info;
+		info.name        = pool.intern( f.name );
+		info.module_name = pool.intern( f.module_name );
+		info.category    = f.category;
+		info.included_files.reserve( f.included_files.size() );
+		for( const auto& header : f.included_files ) {
+			info.included_files.push_back( pool.intern( header ) );
+		}
+		ret.push_back( std::move( info ) );
 	}
+	return ret;
+}
 
+std::vector<FileInfo> to_file_infos( const std::vector<InternedFileInfo>& files, const StringPool& pool )
+{
+	std::vector<FileInfo> ret;
+	ret.reserve( files.size() );
+	for( const auto& f : files ) {
+		FileInfo info;
+		info.name        = String_t( pool.view( f.name ) );
+		info.module_name = String_t( pool.view( f.module_name ) );
+		info.category    = f.category;
+		info.included_files.reserve( f.included_files.size() );
+		for( const auto header : f.included_files ) {
+			info.included_files.emplace_back( pool.view( header ) );
+		}
+		ret.push_back( std::move( info ) );
+	}
 	return ret;
 }
 
-auto make_module_dep_map( std::vector<FileInfo> files ) -> std::map<String_t, std::set<String_t>>
+std::vector<FileInfo>
+scan_all_boost_modules( const fs::path& boost_root, const TrackSources track_sources, const TrackTests track_tests )
 {
-	std::sort( files.begin(), files.end(), less_by_name );
+	ScanOptions options;
+	options.track_sources = track_sources;
+	options.track_tests   = track_tests;
+	return scan_all_boost_modules( boost_root, options );
+}
 
-	std::map<String_t, std::set<String_t>> module_dependencies;
-	for( auto& f : files ) {
-		auto& m = module_dependencies[f.module_name];
-		for( const auto& d : f.included_files ) {
-			const FileInfo tmp{d};
-			const auto     it = std::lower_bound( files.begin(), files.end(), tmp, less_by_name );
-			if( it != files.end() && it->name == d ) {
-				m.insert( it->module_name );
-			} else {
-				std::cout << "unknown file  included from " << f.name << " \t: " << d << std::endl;
+std::vector<fs::path> get_scanned_directories( const fs::path& boost_root, const ScanOptions& options )
+{
+	std::vector<fs::path> dirs;
+	if( !options.git_revision.empty() ) {
+		return dirs;
+	}
+	for( auto& root : get_all_scan_roots( boost_root, options ) ) {
+		if( fs::exists( root.dir ) ) {
+			dirs.push_back( std::move( root.dir ) );
+		}
+	}
+	return dirs;
+}
+
+bool rescan_paths( std::vector<FileInfo>&       files,
+				   const fs::path&              boost_root,
+				   const std::vector<fs::path>& changed_paths,
+				   const ScanOptions&           options )
+{
+	if( !options.git_revision.empty() ) {
+		return false; // a commit never changes
+	}
+
+	// The files were just changed and an editor that saves in place (truncate, then write) may still be at it.
+	// A file that shrinks while it is mapped raises SIGBUS, so they are read into a buffer instead
+	auto read_options        = options;
+	read_options.read_method = ReadMethod::Stream;
+
+	const auto roots = get_all_scan_roots( boost_root, options );
+
+	bool changed = false;
+	for( const auto& path : changed_paths ) {
+		const auto path_str = path.generic_string();
+
+		// sublibs are nested in their parent library, so we need the most specific root
+		const ScanRoot* root     = nullptr;
+		std::size_t     root_len = 0;
+		for( const auto& r : roots ) {
+			const auto dir = r.dir.generic_string();
+			if( dir.size() > root_len && is_in_directory( path_str, dir ) ) {
+				root     = &r;
+				root_len = dir.size();
+			}
+		}
+		if( root == nullptr ) {
+			continue;
+		}
+
+		const auto prefix_size = root->prefix.generic_string().size();
+		const auto name        = path_str.size() > prefix_size ? path_str.substr( prefix_size + 1 ) : String_t{};
+		const auto& base       = root->base_template;
+
+		const auto is_affected = [&]( const FileInfo& f ) {
+			return f.module_name == base.module_name && f.category == base.category
+				   && ( name.empty() || is_in_directory( f.name, name ) );
+		};
+
+		auto it = std::stable_partition(
+			files.begin(), files.end(), [&]( const FileInfo& f ) { return !is_affected( f ); } );
+		std::vector<FileInfo> old_files( std::make_move_iterator( it ), std::make_move_iterator( files.end() ) );
+		files.erase( it, files.end() );
+
+		std::vector<FileInfo> new_files;
+		std::error_code       ec;
+		if( fs::is_directory( path, ec ) ) {
+			new_files = scan_files_in_directory( path, root->prefix, read_options, base );
+		} else if( fs::is_regular_file( path, ec ) ) {
+			const auto file_class = classify( options, path_str );
+			if( file_class != FileClass::Skipped ) {
+				const bool sniff = file_class == FileClass::Unknown;
+				if( auto headers = get_included_boost_headers( path, read_options, sniff ) ) {
+					FileInfo f       = base;
+					f.name           = name;
+					f.included_files = std::move( *headers );
+					new_files.push_back( std::move( f ) );
+				}
 			}
 		}
+
+		const auto same_file = []( const FileInfo& l, const FileInfo& r ) {
+			return l.name == r.name && l.included_files == r.included_files;
+		};
+		const auto by_name = []( const FileInfo& l, const FileInfo& r ) { return l.name < r.name; };
+		std::sort( old_files.begin(), old_files.end(), by_name );
+		std::sort( new_files.begin(), new_files.end(), by_name );
+		if( !std::equal( old_files.begin(), old_files.end(), new_files.begin(), new_files.end(), same_file ) ) {
+			changed = true;
+		}
+
+		// keep the files of a module together
+		const auto pos = std::upper_bound( files.begin(), files.end(), base, []( const auto& l, const auto& r ) {
+			return l.module_name < r.module_name;
+		} );
+		files.insert( pos, std::make_move_iterator( new_files.begin() ), std::make_move_iterator( new_files.end() ) );
 	}
-	return module_dependencies;
+	return changed;
 }
 
-// tanslate internal format into the API format
-DependencyInfo to_default_format( std::map<String_t, std::set<String_t>>&& in )
+//########################################## analysis ########################################################
+
+void UnresolvedIncludes::add( std::string_view module, std::string_view header, std::size_t count )
 {
-	DependencyInfo ret;
-	for( auto& m : in ) {
-		m.second.erase( m.first ); // make sure there is no self-dependency
-		ret[m.first] = mdev::to_vector<String_t>( std::move( m.second ) );
+	auto m = _modules.find( module );
+	if( m == _modules.end() ) {
+		m = _modules.emplace( String_t( module ), std::map<String_t, std::size_t, std::less<>>{} ).first;
+	}
+	auto h = m->second.find( header );
+	if( h == m->second.end() ) {
+		h = m->second.emplace( String_t( header ), 0 ).first;
+	}
+	h->second += count;
+}
+
+void UnresolvedIncludes::merge( const UnresolvedIncludes& other )
+{
+	for( const auto& [module, headers] : other._modules ) {
+		for( const auto& [header, cnt] : headers ) {
+			add( module, header, cnt );
+		}
+	}
+}
+
+std::size_t UnresolvedIncludes::count( std::string_view module, std::string_view header ) const
+{
+	const auto m = _modules.find( module );
+	if( m == _modules.end() ) {
+		return 0;
+	}
+	const auto h = m->second.find( header );
+	return h == m->second.end() ? 0 : h->second;
+}
+
+std::size_t UnresolvedIncludes::size() const
+{
+	std::size_t ret = 0;
+	for( const auto& [module, headers] : _modules ) {
+		ret += headers.size();
 	}
 	return ret;
 }
 
-} // namespace
+std::size_t UnresolvedIncludes::total() const
+{
+	std::size_t ret = 0;
+	for( const auto& [module, headers] : _modules ) {
+		for( const auto& [header, cnt] : headers ) {
+			ret += cnt;
+		}
+	}
+	return ret;
+}
 
-DependencyInfo build_module_dependency_map( const std::vector<FileInfo>& files )
+std::vector<UnresolvedIncludes::Entry> UnresolvedIncludes::entries() const
 {
-	return to_default_format( make_module_dep_map( files ) );
+	std::vector<Entry> ret;
+	for( const auto& [module, headers] : _modules ) {
+		for( const auto& [header, cnt] : headers ) {
+			ret.push_back( {module, header, cnt} );
+		}
+	}
+	return ret;
 }
 
-DependencyInfo build_filtered_module_dependency_map( const std::vector<FileInfo>& files, std::string_view root_module )
+namespace {
+
+std::chrono::nanoseconds* timer_target( AnalysisStats* stats, std::chrono::nanoseconds AnalysisStats::*member )
 {
-	return to_default_format( make_module_dep_map( filter_files( files, root_module ) ) );
+	return stats ? &( stats->*member ) : nullptr;
 }
 
-DependencyInfo build_filtered_file_dependency_map( const std::vector<FileInfo>& files, std::string_view root_module )
+FileIndex make_index( const std::vector<FileInfo>& files, AnalysisStats* stats )
 {
-	DependencyInfo ret;
+	ScopedTimer timer( timer_target( stats, &AnalysisStats::index_time ) );
+	return FileIndex( files );
+}
+
+// View for the shared analysis in dependency_maps.hpp: includes are resolved by looking up their names in the index
+class IndexedFiles {
+public:
+	using Id                                    = std::size_t; // position in the vector of the FileIndex
+	static constexpr std::size_t files_per_task = 512;
 
-	// Add a fake file representing the root module
-	auto& root_node = ret[String_t(root_module)];
+	explicit IndexedFiles( const FileIndex& index )
+		: _index( index )
+	{
+	}
 
-	for( auto& file : filter_files( files, root_module ) ) {
-		if( file.module_name == root_module ) {
-			root_node.push_back( file.name );
+	std::size_t      size() const { return _index.files().size(); }
+	std::string_view name( Id file ) const { return _index.files()[file].name; }
+	std::string_view module_name( Id file ) const { return _index.files()[file].module_name; }
+
+	template<class Resolved, class Unresolved>
+	void for_each_include( Id file, Resolved&& resolved, Unresolved&& unresolved ) const
+	{
+		for( const auto& inc : _index.files()[file].included_files ) {
+			const auto pos = _index.find( inc );
+			if( pos != FileIndex::npos ) {
+				resolved( pos );
+			} else {
+				unresolved( inc );
+			}
 		}
-		ret[file.name] = file.included_files;
 	}
 
-	std::sort( root_node.begin(), root_node.end() );
+private:
+	const FileIndex& _index;
+};
 
-	return ret;
+using FilePositions = std::vector<IndexedFiles::Id>;
+
+FilePositions filter_files( const FileIndex& index, std::string_view root_module, AnalysisStats* stats )
+{
+	ScopedTimer timer( timer_target( stats, &AnalysisStats::filter_time ) );
+	return reachable_files( IndexedFiles( index ), root_module );
+}
+
+DependencyGraph make_module_dependency_map( const FileIndex& index, AnalysisStats* stats )
+{
+	const IndexedFiles files( index );
+	return to_default_format( make_module_dep_map( files, all_files( files ), stats ) );
+}
+
+DependencyGraph
+make_filtered_module_dependency_map( const FileIndex& index, std::string_view root_module, AnalysisStats* stats )
+{
+	const auto filtered = filter_files( index, root_module, stats );
+	return to_default_format( make_module_dep_map( IndexedFiles( index ), filtered, stats ) );
+}
+
+DependencyGraph
+make_filtered_file_dependency_map( const FileIndex& index, std::string_view root_module, AnalysisStats* stats )
+{
+	const auto filtered = filter_files( index, root_module, stats );
+	return make_filtered_file_dep_map( IndexedFiles( index ), filtered, root_module, stats );
+}
+
+} // namespace
+
+DependencyGraph build_module_dependency_map( const std::vector<FileInfo>& files, AnalysisStats* stats )
+{
+	AnalysisScope scope( stats, files.size() );
+	return scope.done( make_module_dependency_map( make_index( files, stats ), stats ) );
+}
+
+DependencyGraph build_module_dependency_map( const FileIndex& index, AnalysisStats* stats )
+{
+	AnalysisScope scope( stats, index.files().size() );
+	return scope.done( make_module_dependency_map( index, stats ) );
+}
+
+DependencyGraph build_filtered_module_dependency_map( const std::vector<FileInfo>& files,
+													  std::string_view             root_module,
+													  AnalysisStats*               stats )
+{
+	AnalysisScope scope( stats, files.size() );
+	return scope.done( make_filtered_module_dependency_map( make_index( files, stats ), root_module, stats ) );
+}
+
+DependencyGraph
+build_filtered_module_dependency_map( const FileIndex& index, std::string_view root_module, AnalysisStats* stats )
+{
+	AnalysisScope scope( stats, index.files().size() );
+	return scope.done( make_filtered_module_dependency_map( index, root_module, stats ) );
+}
+
+DependencyGraph build_filtered_file_dependency_map( const std::vector<FileInfo>& files,
+													std::string_view             root_module,
+													AnalysisStats*               stats )
+{
+	AnalysisScope scope( stats, files.size() );
+	return scope.done( make_filtered_file_dependency_map( make_index( files, stats ), root_module, stats ) );
+}
+
+DependencyGraph
+build_filtered_file_dependency_map( const FileIndex& index, std::string_view root_module, AnalysisStats* stats )
+{
+	AnalysisScope scope( stats, index.files().size() );
+	return scope.done( make_filtered_file_dependency_map( index, root_module, stats ) );
 }
 
 } // namespace mdev::boostdep
@@ -1,10 +1,20 @@
 #pragma once
 
+#include "bounded_queue.hpp"
+#include "dependency_graph.hpp"
+#include "include_prefilter.hpp"
+#include "string_pool.hpp"
+#include "task_scheduler.hpp"
 #include "utils.hpp"
 
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <map>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace mdev::boostdep {
 
@@ -12,6 +22,24 @@ enum class TrackSources { No, Yes };
 enum class TrackTests { No, Yes };
 enum class TrackOrigin { No, Yes };
 
+// Stream is the original std::ifstream + std::getline based scanner, which is kept around for benchmarking.
+// IoUring keeps many reads in flight at once (helps with a cold page cache / slow file systems).
+// It is linux only and behaves like MemoryMap where io_uring isn't available
+enum class ReadMethod { Stream, MemoryMap, IoUring };
+
+// WorkStealing: Directories and batches of files are tasks for a work stealing scheduler, each task reads and parses
+// its own files.
+// Pipeline: Walking the directories, reading and parsing are separate stages with their own threads, connected by
+// bounded queues. Lets reading and parsing overlap with only a few threads and shows which stage is the bottleneck.
+enum class ScanStrategy { WorkStealing, Pipeline };
+
+struct PipelineOptions {
+	std::size_t walker_threads = 1;
+	std::size_t reader_threads = 2;
+	std::size_t parser_threads = 0; // 0: ScanOptions::thread_count
+	std::size_t queue_capacity = 1024;
+};
+
 enum class FileCategory { Unknown, Header, Source, Test };
 struct FileInfo {
 	String_t              name;
@@ -20,17 +48,199 @@ struct FileInfo {
 	FileCategory          category;
 };
 
+// Same as FileInfo, but all strings are interned in a StringPool.
+// Files with the same name always have the same symbol, so comparisons are cheap
+// and every string is only stored once, no matter how often it is included.
+struct InternedFileInfo {
+	Symbol              name = invalid_symbol;
+	std::vector<Symbol> included_files;
+	Symbol              module_name = invalid_symbol;
+	FileCategory        category    = FileCategory::Unknown;
+};
+
+class ScanCache;
+class ContentDedupTable;
+class FileIndex;
+struct FileClassifier;
+
+struct ScanOptions {
+	TrackSources track_sources = TrackSources::Yes;
+	TrackTests   track_tests   = TrackTests::No;
+	ReadMethod   read_method   = ReadMethod::MemoryMap;
+	ScanStrategy strategy      = ScanStrategy::WorkStealing;
+
+	// Only used with ScanStrategy::Pipeline (which ignores the read method, the readers always copy into a buffer)
+	PipelineOptions pipeline;
+
+	// If set, only files that changed since they were put into the cache are parsed again
+	ScanCache* cache = nullptr;
+
+	// If set, files with a content that was already parsed before (e.g. when scanning another boost release
+	// with the same table) are not parsed again. Has no effect with ReadMethod::Stream
+	ContentDedupTable* dedup = nullptr;
+
+	// If set, files it rejects (images, docs, build files ...) are neither parsed nor part of the result
+	const FileClassifier* classifier = nullptr;
+
+	// Includes of paths below these roots are collected (nullptr: IncludeMatcher::boost()).
+	// The cache and the dedup table don't know which matcher produced an entry, so they shouldn't be shared between
+	// scans with different matchers
+	const IncludeMatcher* include_matcher = nullptr;
+
+	// 0: one thread per hardware thread
+	std::size_t thread_count = 0;
+
+	// If set, the files are read from the git object store of boost_root at this revision (commit id, branch or tag)
+	// instead of from the working tree. Submodules only have to be cloned (e.g. into .git/modules), not checked out.
+	// The cache and the read method are not used in this case
+	String_t git_revision;
+};
+
+struct StageStats {
+	String_t                 name;
+	std::size_t              threads = 0;
+	std::size_t              items   = 0;
+	std::chrono::nanoseconds busy{0};  // summed over all threads of the stage, without waiting for the queues
+	std::chrono::nanoseconds total{0}; // wall time of the whole pipeline
+	QueueStats               input;    // the queue the stage takes its items from (unused for the first stage)
+
+	double utilization() const
+	{
+		return total.count() == 0 || threads == 0 ? 0.0 : double( busy.count() ) / double( total.count() * threads );
+	}
+};
+
+struct ModuleScanStats {
+	String_t                 name;
+	std::size_t              files = 0;
+	std::chrono::nanoseconds time{0}; // reading and parsing, summed over all threads
+};
+
+// Time is wall time, unless noted otherwise. The byte/line/include counters only cover files that were actually
+// read/parsed (not the ones served by the scan cache or the dedup table).
+struct ScanStats {
+	std::chrono::nanoseconds total{0};
+	std::chrono::nanoseconds walk_time{0}; // listing directories (git: reading trees), summed over all threads
+
+	std::size_t   files              = 0;
+	std::size_t   skipped_files      = 0; // rejected by ScanOptions::classifier
+	std::uint64_t bytes_read         = 0;
+	std::uint64_t lines_inspected    = 0;
+	std::uint64_t include_candidates = 0; // lines the prefilter handed to the include parser
+	std::uint64_t include_hits       = 0; // boost includes found
+
+	std::vector<ModuleScanStats> modules;
+	std::vector<WorkerStats>     workers; // ScanStrategy::WorkStealing
+	std::vector<StageStats>      stages;  // ScanStrategy::Pipeline
+};
+
+std::vector<FileInfo> scan_all_boost_modules( const std::filesystem::path& boost_root,
+											  const ScanOptions&           options,
+											  ScanStats*                   stats = nullptr );
+
 std::vector<FileInfo> scan_all_boost_modules( const std::filesystem::path& boost_root,
 											  const TrackSources           track_sources,
 											  const TrackTests             track_tests );
 
-using DependencyInfo = std::map < String_t, std::vector<String_t>> ;
+// Same as scan_all_boost_modules, but interns the strings right away, so the scan result never holds
+// more than one copy of each file name
+std::vector<InternedFileInfo> scan_all_boost_modules_interned( const std::filesystem::path& boost_root,
+															   const ScanOptions&           options,
+															   ScanStats*                   stats = nullptr,
+															   StringPool&                  pool  = global_string_pool() );
+
+std::vector<InternedFileInfo> intern_files( const std::vector<FileInfo>& files, StringPool& pool = global_string_pool() );
+std::vector<FileInfo>         to_file_infos( const std::vector<InternedFileInfo>& files,
+											 const StringPool&                    pool = global_string_pool() );
+
+// The directories scan_all_boost_modules looks at (e.g. in order to watch them for changes)
+std::vector<std::filesystem::path> get_scanned_directories( const std::filesystem::path& boost_root,
+															const ScanOptions&           options );
+
+// Updates files (as returned by scan_all_boost_modules) for the given changed files or directories:
+// Paths that no longer exist are removed, everything else is scanned again.
+// Only paths below the directories of existing modules are considered (new modules require a full scan).
+// The files are always streamed (options.read_method is ignored), they might still be written to.
+// Returns true if anything changed.
+bool rescan_paths( std::vector<FileInfo>&                    files,
+				   const std::filesystem::path&              boost_root,
+				   const std::vector<std::filesystem::path>& changed_paths,
+				   const ScanOptions&                        options );
+
+// All modules in boost_root/libs (module name -> module directory). Sublibs are named <parent>~<sublib>
+std::map<String_t, std::filesystem::path> find_boost_modules( const std::filesystem::path& boost_root );
+
+// Reads file and extracts all boost headers it includes (using the read method, cache and dedup table of options)
+std::vector<String_t> get_included_boost_headers( const std::filesystem::path& file, const ScanOptions& options = {} );
+
+// Extracts all boost headers (or headers below the roots of matcher) that are included in a file with the given content
+std::vector<String_t> parse_included_boost_headers( std::string_view      content,
+													PrefilterKernel       kernel  = PrefilterKernel::Auto,
+													const IncludeMatcher& matcher = IncludeMatcher::boost() );
+
+// Includes that don't refer to any scanned file, counted per (including module, missing header)
+class UnresolvedIncludes {
+public:
+	struct Entry {
+		String_t    module;
+		String_t    header;
+		std::size_t count = 0;
+	};
 
-DependencyInfo build_module_dependency_map( const std::vector<FileInfo>& files );
+	void add( std::string_view module, std::string_view header, std::size_t count = 1 );
+	void merge( const UnresolvedIncludes& other );
+
+	// how often module includes header (0 if the header was found or never included)
+	std::size_t count( std::string_view module, std::string_view header ) const;
+
+	bool        empty() const { return _modules.empty(); }
+	std::size_t size() const;  // distinct (module, header) pairs
+	std::size_t total() const; // sum of all counts
+
+	// sorted by module and header
+	std::vector<Entry> entries() const;
+
+private:
+	std::map<String_t, std::map<String_t, std::size_t, std::less<>>, std::less<>> _modules;
+};
+
+// The build_*_dependency_map functions add their times and counts, generate_module_list also fills in
+// the closure and level times
+struct AnalysisStats {
+	std::chrono::nanoseconds total{0};
+	std::chrono::nanoseconds filter_time{0};  // following the include chains from the root module
+	std::chrono::nanoseconds index_time{0};   // building the FileIndex (for the lookups)
+	std::chrono::nanoseconds dep_map_time{0}; // resolving the includes
+	std::chrono::nanoseconds closure_time{0}; // transitive dependencies
+	std::chrono::nanoseconds level_time{0};   // module levels
+
+	std::size_t files               = 0; // input of the dependency map
+	std::size_t nodes               = 0; // modules (or files) in the dependency map
+	std::size_t resolved_includes   = 0;
+	std::size_t unresolved_includes = 0;
+
+	UnresolvedIncludes unresolved;
+};
+
+DependencyGraph build_module_dependency_map( const std::vector<FileInfo>& files, AnalysisStats* stats = nullptr );
 
 // This will only return modules that the files in root_module directly or indirectly depend on
 // Note: This function is tracking actual include chains - not "library level dependencies"
-DependencyInfo build_filtered_module_dependency_map( const std::vector<FileInfo>& files, std::string_view root_module );
+DependencyGraph build_filtered_module_dependency_map( const std::vector<FileInfo>& files,
+													  std::string_view             root_module,
+													  AnalysisStats*               stats = nullptr );
+
+DependencyGraph build_filtered_file_dependency_map( const std::vector<FileInfo>& files,
+													std::string_view             root_module,
+													AnalysisStats*               stats = nullptr );
 
-DependencyInfo build_filtered_file_dependency_map( const std::vector<FileInfo>& files, std::string_view root_module );
+// Same as above, but the files are looked up in an existing index (of the scan result) instead of building one for
+// every call
+DependencyGraph build_module_dependency_map( const FileIndex& index, AnalysisStats* stats = nullptr );
+DependencyGraph build_filtered_module_dependency_map( const FileIndex& index,
+													  std::string_view root_module,
+													  AnalysisStats*   stats = nullptr );
+DependencyGraph build_filtered_file_dependency_map( const FileIndex& index,
+													std::string_view root_module,
+													AnalysisStats*   stats = nullptr );
 } // namespace mdev::boostdep
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+namespace mdev {
+
+struct QueueStats {
+	std::size_t capacity    = 0;
+	std::size_t max_depth   = 0;
+	double      avg_depth   = 0; // sampled on every push
+	std::size_t push_stalls = 0; // number of times a producer had to wait because the queue was full
+	std::size_t pop_stalls  = 0; // number of times a consumer had to wait because the queue was empty
+};
+
+/**
+ * Bounded lock free multi producer / multi consumer queue (based on Dmitry Vyukov's algorithm).
+ *
+ * try_push/try_pop never block. push/pop wait (spinning, then sleeping) until they succeed.
+ * Once all producers are done, close() makes pop() return false as soon as the queue is drained.
+ */
+template<class T>
+class BoundedQueue {
+public:
+	// capacity is rounded up to a power of two
+	explicit BoundedQueue( std::size_t capacity )
+	{
+		std::size_t size = 2;
+		while( size < capacity ) {
+			size *= 2;
+		}
+		_mask  = size - 1;
+		_cells = std::make_unique<Cell[]>( size );
+		for( std::size_t i = 0; i < size; ++i ) {
+			_cells[i].sequence.store( i, std::memory_order_relaxed );
+		}
+	}
+
+	BoundedQueue( const BoundedQueue& ) = delete;
+	BoundedQueue& operator=( const BoundedQueue& ) = delete;
+
+	std::size_t capacity() const { return _mask + 1; }
+
+	// approximate, if other threads are pushing or popping at the same time
+	std::size_t depth() const
+	{
+		const auto tail = _tail.load( std::memory_order_relaxed );
+		const auto head = _head.load( std::memory_order_relaxed );
+		return tail > head ? tail - head : 0;
+	}
+
+	bool try_push( T&& value )
+	{
+		auto pos = _tail.load( std::memory_order_relaxed );
+		for( ;; ) {
+			Cell&      cell = _cells[pos & _mask];
+			const auto seq  = cell.sequence.load( std::memory_order_acquire );
+			const auto diff = static_cast<std::ptrdiff_t>( seq ) - static_cast<std::ptrdiff_t>( pos );
+			if( diff == 0 ) {
+				if( _tail.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) {
+					cell.value = std::move( value );
+					cell.sequence.store( pos + 1, std::memory_order_release );
+					return true;
+				}
+			} else if( diff < 0 ) {
+				return false; // full
+			} else {
+				pos = _tail.load( std::memory_order_relaxed );
+			}
+		}
+	}
+
+	bool try_pop( T& value )
+	{
+		auto pos = _head.load( std::memory_order_relaxed );
+		for( ;; ) {
+			Cell&      cell = _cells[pos & _mask];
+			const auto seq  = cell.sequence.load( std::memory_order_acquire );
+			const auto diff = static_cast<std::ptrdiff_t>( seq ) - static_cast<std::ptrdiff_t>( pos + 1 );
+			if( diff == 0 ) {
+				if( _head.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) {
+					value = std::move( cell.value );
+					cell.sequence.store( pos + _mask + 1, std::memory_order_release );
+					return true;
+				}
+			} else if( diff < 0 ) {
+				return false; // empty
+			} else {
+				pos = _head.load( std::memory_order_relaxed );
+			}
+		}
+	}
+
+	void push( T value )
+	{
+		record_depth( depth() + 1 );
+		if( try_push( std::move( value ) ) ) {
+			return;
+		}
+		_push_stalls.fetch_add( 1, std::memory_order_relaxed );
+		for( int round = 0; !try_push( std::move( value ) ); ++round ) {
+			backoff( round );
+		}
+	}
+
+	// returns false once the queue is closed and empty
+	bool pop( T& value )
+	{
+		if( try_pop( value ) ) {
+			return true;
+		}
+		_pop_stalls.fetch_add( 1, std::memory_order_relaxed );
+		for( int round = 0;; ++round ) {
+			if( try_pop( value ) ) {
+				return true;
+			}
+			if( _closed.load( std::memory_order_acquire ) ) {
+				return try_pop( value ); // something might have been pushed right before close()
+			}
+			backoff( round );
+		}
+	}
+
+	void close() { _closed.store( true, std::memory_order_release ); }
+
+	QueueStats stats() const
+	{
+		QueueStats s;
+		s.capacity         = capacity();
+		s.max_depth        = _max_depth.load();
+		const auto samples = _depth_samples.load();
+		s.avg_depth        = samples == 0 ? 0.0 : double( _depth_sum.load() ) / double( samples );
+		s.push_stalls      = _push_stalls.load();
+		s.pop_stalls       = _pop_stalls.load();
+		return s;
+	}
+
+private:
+	struct Cell {
+		std::atomic<std::size_t> sequence{0};
+		T                        value{};
+	};
+
+	static void backoff( int round )
+	{
+		if( round < 64 ) {
+			std::this_thread::yield();
+		} else {
+			std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+		}
+	}
+
+	void record_depth( std::size_t depth )
+	{
+		depth = std::min( depth, capacity() );
+		_depth_sum.fetch_add( depth, std::memory_order_relaxed );
+		_depth_samples.fetch_add( 1, std::memory_order_relaxed );
+		auto max = _max_depth.load( std::memory_order_relaxed );
+		while( depth > max && !_max_depth.compare_exchange_weak( max, depth, std::memory_order_relaxed ) ) {
+		}
+	}
+
+	std::unique_ptr<Cell[]> _cells;
+	std::size_t             _mask = 0;
+
+	// head and tail are on different cache lines, so producers and consumers don't fight over them
+	alignas( 64 ) std::atomic<std::size_t> _tail{0};
+	alignas( 64 ) std::atomic<std::size_t> _head{0};
+	alignas( 64 ) std::atomic<bool> _closed{false};
+
+	std::atomic<std::size_t> _max_depth{0};
+	std::atomic<std::size_t> _depth_sum{0};
+	std::atomic<std::size_t> _depth_samples{0};
+	std::atomic<std::size_t> _push_stalls{0};
+	std::atomic<std::size_t> _pop_stalls{0};
+};
+
+} // namespace mdev
@@ -0,0 +1,57 @@
+#include "content_dedup.hpp"
+
+#include <mutex>
+
+namespace mdev::boostdep {
+
+std::optional<std::vector<String_t>> ContentDedupTable::lookup( const ContentKey& key ) const
+{
+	std::shared_lock lock( _mx );
+	const auto       it = _entries.find( key );
+	if( it == _entries.end() ) {
+		_misses++;
+		return {};
+	}
+	_hits++;
+	return it->second;
+}
+
+void ContentDedupTable::store( const ContentKey& key, const std::vector<String_t>& included_files )
+{
+	std::unique_lock lock( _mx );
+	_entries.try_emplace( key, included_files );
+}
+
+std::optional<std::vector<String_t>> ContentDedupTable::lookup( const git::ObjectId& blob ) const
+{
+	std::shared_lock lock( _mx );
+	const auto       it = _blobs.find( blob );
+	if( it == _blobs.end() ) {
+		return {}; // not a miss yet - the caller will look up the content next
+	}
+	_hits++;
+	return it->second;
+}
+
+void ContentDedupTable::store( const git::ObjectId& blob, const std::vector<String_t>& included_files )
+{
+	std::unique_lock lock( _mx );
+	_blobs.try_emplace( blob, included_files );
+}
+
+void ContentDedupTable::clear()
+{
+	std::unique_lock lock( _mx );
+	_entries.clear();
+	_blobs.clear();
+	_hits   = 0;
+	_misses = 0;
+}
+
+std::size_t ContentDedupTable::size() const
+{
+	std::shared_lock lock( _mx );
+	return _entries.size() + _blobs.size();
+}
+
+} // namespace mdev::boostdep
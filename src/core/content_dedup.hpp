@@ -0,0 +1,66 @@
+#pragma once
+
+#include "git_repository.hpp"
+#include "utils.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mdev::boostdep {
+
+// Identifies a file content (64 bit hash + size, so a collision would also need the same size)
+struct ContentKey {
+	std::uint64_t hash = 0;
+	std::uint64_t size = 0;
+
+	friend bool operator==( const ContentKey& l, const ContentKey& r ) { return l.hash == r.hash && l.size == r.size; }
+};
+
+/**
+ * Remembers the included files per file content, so identical files (e.g. the same header in different boost
+ * releases, forks or sublibraries) only have to be parsed once.
+ *
+ * Unlike ScanCache this is independent of the file's path, but the file still has to be read to compute the hash.
+ * Blobs from a git repository are identified by their object id instead, so they don't even have to be read.
+ * lookup and store may be called concurrently.
+ */
+class ContentDedupTable {
+public:
+	static ContentKey make_key( std::string_view content ) { return {hash64( content ), content.size()}; }
+
+	std::optional<std::vector<String_t>> lookup( const ContentKey& key ) const;
+	void                                 store( const ContentKey& key, const std::vector<String_t>& included_files );
+
+	std::optional<std::vector<String_t>> lookup( const git::ObjectId& blob ) const;
+	void store( const git::ObjectId& blob, const std::vector<String_t>& included_files );
+
+	void        clear();
+	std::size_t size() const;
+	std::size_t hits() const { return _hits; }
+	std::size_t misses() const { return _misses; }
+
+private:
+	struct KeyHash {
+		std::size_t operator()( const ContentKey& key ) const { return static_cast<std::size_t>( key.hash ); }
+		std::size_t operator()( const git::ObjectId& id ) const
+		{
+			std::size_t h = 0;
+			std::memcpy( &h, id.bytes.data(), sizeof( h ) ); // already a (cryptographic) hash
+			return h;
+		}
+	};
+
+	mutable std::shared_mutex                                         _mx;
+	std::unordered_map<ContentKey, std::vector<String_t>, KeyHash>    _entries;
+	std::unordered_map<git::ObjectId, std::vector<String_t>, KeyHash> _blobs;
+	mutable std::atomic<std::size_t>                                  _hits{0};
+	mutable std::atomic<std::size_t>                                  _misses{0};
+};
+
+} // namespace mdev::boostdep
@@ -0,0 +1,140 @@
+#include "dependency_graph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace mdev::boostdep {
+
+DependencyGraph::DependencyGraph( const std::vector<std::string_view>& names,
+								  const std::vector<std::uint32_t>&    offsets,
+								  const std::vector<NodeId>&           deps )
+{
+	if( offsets.size() != names.size() + 1 || offsets.back() != deps.size() ) {
+		throw std::invalid_argument( "DependencyGraph: offsets don't match the nodes / dependencies" );
+	}
+	if( std::any_of( deps.begin(), deps.end(), [&]( NodeId d ) { return d >= names.size(); } ) ) {
+		throw std::invalid_argument( "DependencyGraph: dependency on an unknown node" );
+	}
+
+	for( const auto name : names ) {
+		_string_data.insert( _string_data.end(), name.begin(), name.end() );
+		_string_offsets.push_back( static_cast<std::uint32_t>( _string_data.size() ) );
+	}
+
+	// sorted and without duplicates, so two graphs with the same edges compare equal
+	_offsets.reserve( offsets.size() );
+	_deps.reserve( deps.size() );
+	for( std::size_t n = 0; n < names.size(); ++n ) {
+		const auto begin = _deps.size();
+		_deps.insert( _deps.end(), deps.begin() + offsets[n], deps.begin() + offsets[n + 1] );
+		std::sort( _deps.begin() + begin, _deps.end() );
+		_deps.erase( std::unique( _deps.begin() + begin, _deps.end() ), _deps.end() );
+		_offsets.push_back( static_cast<std::uint32_t>( _deps.size() ) );
+	}
+
+	// reverse edges with a counting sort (iterating the sources in order keeps each list sorted)
+	_rev_offsets.assign( names.size() + 1, 0 );
+	for( const auto d : _deps ) {
+		_rev_offsets[d + 1]++;
+	}
+	for( std::size_t n = 0; n < names.size(); ++n ) {
+		_rev_offsets[n + 1] += _rev_offsets[n];
+	}
+	_rev_deps.resize( _deps.size() );
+	auto next = _rev_offsets;
+	for( NodeId n = 0; n < names.size(); ++n ) {
+		for( const auto d : this->deps( n ) ) {
+			_rev_deps[next[d]++] = n;
+		}
+	}
+}
+
+DependencyGraph DependencyGraph::from_edges( const std::vector<std::string_view>&  names,
+											std::vector<std::pair<NodeId, NodeId>> edges )
+{
+	std::sort( edges.begin(), edges.end() );
+
+	std::vector<std::uint32_t> offsets( names.size() + 1, 0 );
+	std::vector<NodeId>        deps;
+	deps.reserve( edges.size() );
+	for( const auto& [node, dep] : edges ) {
+		if( node >= names.size() ) {
+			throw std::invalid_argument( "DependencyGraph: dependency of an unknown node" );
+		}
+		offsets[node + 1]++;
+		deps.push_back( dep );
+	}
+	for( std::size_t n = 0; n < names.size(); ++n ) {
+		offsets[n + 1] += offsets[n];
+	}
+	return DependencyGraph( names, offsets, deps );
+}
+
+namespace {
+
+std::vector<std::string_view> keys( const DependencyInfo& info )
+{
+	std::vector<std::string_view> ret;
+	ret.reserve( info.size() );
+	for( const auto& [name, deps] : info ) {
+		ret.push_back( name );
+	}
+	return ret;
+}
+
+} // namespace
+
+DependencyGraph::DependencyGraph( const DependencyInfo& info )
+{
+	const auto names = keys( info );
+
+	std::vector<std::uint32_t> offsets{0};
+	std::vector<NodeId>        deps;
+	for( const auto& [name, node_deps] : info ) {
+		for( const auto& d : node_deps ) {
+			const auto it = std::lower_bound( names.begin(), names.end(), d );
+			if( it != names.end() && *it == d ) {
+				deps.push_back( static_cast<NodeId>( it - names.begin() ) );
+			}
+		}
+		offsets.push_back( static_cast<std::uint32_t>( deps.size() ) );
+	}
+	*this = DependencyGraph( names, offsets, deps );
+}
+
+DependencyGraph::NodeId DependencyGraph::find( std::string_view name ) const
+{
+	// binary search over the (sorted) names
+	NodeId first = 0;
+	NodeId last  = static_cast<NodeId>( size() );
+	while( first < last ) {
+		const auto mid = first + ( last - first ) / 2;
+		if( this->name( mid ) < name ) {
+			first = mid + 1;
+		} else {
+			last = mid;
+		}
+	}
+	return first < size() && this->name( first ) == name ? first : npos;
+}
+
+bool operator==( const DependencyGraph& l, const DependencyGraph& r )
+{
+	// the reverse edges follow from the rest
+	return l._string_data == r._string_data && l._string_offsets == r._string_offsets && l._offsets == r._offsets
+		   && l._deps == r._deps;
+}
+
+DependencyInfo to_dependency_info( const DependencyGraph& graph )
+{
+	DependencyInfo ret;
+	for( DependencyGraph::NodeId n = 0; n < graph.size(); ++n ) {
+		auto& out = ret[String_t( graph.name( n ) )];
+		for( const auto d : graph.deps( n ) ) {
+			out.emplace_back( graph.name( d ) );
+		}
+	}
+	return ret;
+}
+
+} // namespace mdev::boostdep
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "utils.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mdev::boostdep {
+
+// node name -> names of the nodes it depends on
+using DependencyInfo = std::map<String_t, std::vector<String_t>>;
+
+/**
+ * Result of the build_*_dependency_map functions (modules or files and their direct dependencies).
+ *
+ * Node ids are dense and follow the order of the node names. The dependencies of node i are
+ * deps[offsets[i]] ... deps[offsets[i+1]-1] (sorted, without duplicates), the reverse dependencies
+ * are stored the same way. So everything that works on the graph is plain array indexing, and as
+ * the graph never changes after construction, it can be shared between threads.
+ */
+class DependencyGraph {
+public:
+	using NodeId                 = std::uint32_t;
+	static constexpr NodeId npos = ~NodeId{0};
+
+	DependencyGraph() = default;
+
+	// names have to be sorted and unique. The dependencies of node i are deps[offsets[i]] ... deps[offsets[i+1]-1]
+	DependencyGraph( const std::vector<std::string_view>& names,
+					 const std::vector<std::uint32_t>&    offsets,
+					 const std::vector<NodeId>&           deps );
+
+	// names have to be sorted and unique, edges are (node, dependency) pairs in any order
+	static DependencyGraph from_edges( const std::vector<std::string_view>&  names,
+									   std::vector<std::pair<NodeId, NodeId>> edges );
+
+	// Dependencies on names that aren't keys of info (e.g. unresolved includes in a file map) are dropped
+	explicit DependencyGraph( const DependencyInfo& info );
+
+	std::size_t size() const { return _string_offsets.size() - 1; }
+	bool        empty() const { return size() == 0; }
+	std::size_t edge_count() const { return _deps.size(); }
+
+	std::string_view name( NodeId node ) const
+	{
+		return {_string_data.data() + _string_offsets[node], _string_offsets[node + 1] - _string_offsets[node]};
+	}
+	// npos if there is no such node
+	NodeId find( std::string_view name ) const;
+
+	span<const NodeId> deps( NodeId node ) const
+	{
+		return {_deps.data() + _offsets[node], _offsets[node + 1] - _offsets[node]};
+	}
+	span<const NodeId> rev_deps( NodeId node ) const
+	{
+		return {_rev_deps.data() + _rev_offsets[node], _rev_offsets[node + 1] - _rev_offsets[node]};
+	}
+
+	friend bool operator==( const DependencyGraph& l, const DependencyGraph& r );
+	friend bool operator!=( const DependencyGraph& l, const DependencyGraph& r ) { return !( l == r ); }
+
+private:
+	std::vector<char>          _string_data;
+	std::vector<std::uint32_t> _string_offsets{0};
+
+	std::vector<std::uint32_t> _offsets{0};
+	std::vector<NodeId>        _deps;
+	std::vector<std::uint32_t> _rev_offsets{0};
+	std::vector<NodeId>        _rev_deps;
+};
+
+// The old string based format (e.g. for printing or comparing with a hand written map)
+DependencyInfo to_dependency_info( const DependencyGraph& graph );
+
+} // namespace mdev::boostdep
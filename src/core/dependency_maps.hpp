@@ -0,0 +1,248 @@
+#pragma once
+
+#include "bitset.hpp"
+#include "boostdep.hpp"
+#include "dependency_graph.hpp"
+#include "module_sets.hpp"
+#include "task_scheduler.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mdev::boostdep {
+
+/*
+ * The analysis behind the build_*_dependency_map functions, shared by the FileInfo / FileIndex and the FileGraph
+ * overloads. They only differ in how includes get resolved, so Files is a thin view on either of them:
+ *
+ *   using Id = ...;                              // position of a file, 0 ... size()-1
+ *   static constexpr std::size_t files_per_task; // how make_module_dep_map splits the work
+ *
+ *   std::size_t      size() const;
+ *   std::string_view name( Id file ) const;
+ *   std::string_view module_name( Id file ) const;
+ *
+ *   // calls resolved( Id ) or unresolved( std::string_view header ) for each include of file
+ *   template<class Resolved, class Unresolved>
+ *   void for_each_include( Id file, Resolved&& resolved, Unresolved&& unresolved ) const;
+ */
+
+template<class Files>
+std::vector<typename Files::Id> all_files( const Files& files )
+{
+	std::vector<typename Files::Id> ret( files.size() );
+	for( typename Files::Id f = 0; f < ret.size(); ++f ) {
+		ret[f] = f;
+	}
+	return ret;
+}
+
+// Dense module numbers for the module names of all files, sorted by name
+template<class Files>
+ModuleNumbers number_modules( const Files& files )
+{
+	ModuleNumbers ret;
+	for( typename Files::Id f = 0; f < files.size(); ++f ) {
+		const auto module = files.module_name( f );
+		if( ret.names.empty() || ret.names.back() != module ) { // files of a module are usually together
+			ret.names.push_back( module );
+		}
+	}
+	std::sort( ret.names.begin(), ret.names.end() );
+	ret.names.erase( std::unique( ret.names.begin(), ret.names.end() ), ret.names.end() );
+
+	ret.of_file.reserve( files.size() );
+	for( typename Files::Id f = 0; f < files.size(); ++f ) {
+		const auto module = files.module_name( f );
+		if( ret.of_file.empty() || ret.names[ret.of_file.back()] != module ) {
+			const auto it = std::lower_bound( ret.names.begin(), ret.names.end(), module );
+			ret.of_file.push_back( static_cast<std::uint32_t>( it - ret.names.begin() ) );
+		} else {
+			ret.of_file.push_back( ret.of_file.back() );
+		}
+	}
+	return ret;
+}
+
+// Breadth first search over the include graph, starting with all files of root_module.
+// Returns the (ascending) positions of all files that were reached
+template<class Files>
+std::vector<typename Files::Id> reachable_files( const Files& files, std::string_view root_module )
+{
+	using Id = typename Files::Id;
+
+	DynamicBitset   visited( files.size() );
+	std::vector<Id> queue;
+	const auto      visit = [&]( Id f ) {
+		if( !visited.test_and_set( f ) ) {
+			queue.push_back( f );
+		}
+	};
+
+	for( Id f = 0; f < files.size(); ++f ) {
+		if( files.module_name( f ) == root_module ) {
+			visit( f );
+		}
+	}
+	for( std::size_t head = 0; head < queue.size(); ++head ) {
+		files.for_each_include( queue[head], visit, []( std::string_view ) {} );
+	}
+
+	std::sort( queue.begin(), queue.end() );
+	return queue;
+}
+
+struct ModuleDependencies {
+	ModuleNumbers modules;
+	ModuleSets    deps;
+};
+
+// Resolving the includes is by far the most expensive part, so the files are split into chunks that are processed in
+// parallel. Every thread collects its dependencies in its own ModuleSets and those are combined at the end.
+template<class Files>
+ModuleDependencies
+make_module_dep_map( const Files& files, const std::vector<typename Files::Id>& selected, AnalysisStats* stats )
+{
+	constexpr std::size_t files_per_task = Files::files_per_task;
+
+	ScopedTimer timer( stats ? &stats->dep_map_time : nullptr );
+
+	ModuleDependencies ret{number_modules( files ), {}};
+	const auto&        module_of = ret.modules.of_file;
+
+	TaskScheduler            scheduler( useful_thread_count( selected.size(), files_per_task ) );
+	std::vector<ModuleSets>  partial( scheduler.thread_count(), ModuleSets( ret.modules.names.size() ) );
+	std::atomic<std::size_t> resolved{0};
+
+	// (module, header) per worker, only collected if somebody is interested
+	std::vector<std::vector<std::pair<std::uint32_t, std::string_view>>> unresolved( scheduler.thread_count() );
+	std::atomic<std::size_t>                                             unresolved_cnt{0};
+
+	for( std::size_t begin = 0; begin < selected.size(); begin += files_per_task ) {
+		scheduler.spawn( [&, begin]( std::size_t worker ) {
+			auto&       sets    = partial[worker];
+			std::size_t found   = 0;
+			std::size_t missing = 0;
+			const auto  end     = std::min( selected.size(), begin + files_per_task );
+			for( auto i = begin; i < end; ++i ) {
+				const auto module = module_of[selected[i]];
+				auto&      m      = sets.add_module( module );
+				files.for_each_include(
+					selected[i],
+					[&]( typename Files::Id inc ) {
+						m.set( module_of[inc] );
+						found++;
+					},
+					[&]( std::string_view header ) {
+						missing++;
+						if( stats ) {
+							unresolved[worker].emplace_back( module, header );
+						}
+					} );
+			}
+			resolved += found;
+			unresolved_cnt += missing;
+		} );
+	}
+	scheduler.run();
+
+	ret.deps = std::move( partial[0] );
+	for( std::size_t i = 1; i < partial.size(); ++i ) {
+		ret.deps.merge( partial[i] );
+	}
+
+	if( stats ) {
+		stats->resolved_includes += resolved;
+		stats->unresolved_includes += unresolved_cnt;
+		for( const auto& worker : unresolved ) {
+			for( const auto& [module, header] : worker ) {
+				stats->unresolved.add( ret.modules.names[module], header );
+			}
+		}
+	}
+	return ret;
+}
+
+// translate internal format into the API format
+inline DependencyGraph to_default_format( const ModuleDependencies& in )
+{
+	return in.deps.to_dependency_graph( in.modules.names );
+}
+
+// The nodes are the given files and a fake file representing the root module, which depends on all of its files
+template<class Files>
+DependencyGraph make_filtered_file_dep_map( const Files&                           files,
+											const std::vector<typename Files::Id>& filtered,
+											std::string_view                       root_module,
+											AnalysisStats*                         stats )
+{
+	ScopedTimer timer( stats ? &stats->dep_map_time : nullptr );
+
+	std::vector<std::string_view> names{root_module};
+	for( const auto f : filtered ) {
+		names.push_back( files.name( f ) );
+	}
+	std::sort( names.begin(), names.end() );
+	names.erase( std::unique( names.begin(), names.end() ), names.end() );
+	const auto node = [&]( std::string_view name ) {
+		return static_cast<DependencyGraph::NodeId>( std::lower_bound( names.begin(), names.end(), name )
+													 - names.begin() );
+	};
+
+	std::vector<DependencyGraph::NodeId> node_of( files.size(), DependencyGraph::npos );
+	for( const auto f : filtered ) {
+		node_of[f] = node( files.name( f ) );
+	}
+
+	const auto root = node( root_module );
+
+	std::vector<std::pair<DependencyGraph::NodeId, DependencyGraph::NodeId>> edges;
+	for( const auto f : filtered ) {
+		if( files.module_name( f ) == root_module ) {
+			edges.emplace_back( root, node_of[f] );
+		}
+		files.for_each_include(
+			f,
+			[&]( typename Files::Id inc ) {
+				if( node_of[inc] != DependencyGraph::npos ) {
+					edges.emplace_back( node_of[f], node_of[inc] );
+				}
+			},
+			[]( std::string_view ) {} );
+	}
+
+	return DependencyGraph::from_edges( names, std::move( edges ) );
+}
+
+// Adds the total time, input and output sizes
+class AnalysisScope {
+public:
+	AnalysisScope( AnalysisStats* stats, std::size_t file_cnt )
+		: _stats( stats )
+		, _timer( stats ? &stats->total : nullptr )
+	{
+		if( _stats ) {
+			_stats->files += file_cnt;
+		}
+	}
+
+	DependencyGraph&& done( DependencyGraph&& result )
+	{
+		if( _stats ) {
+			_stats->nodes += result.size();
+		}
+		return std::move( result );
+	}
+
+private:
+	AnalysisStats* _stats;
+	ScopedTimer    _timer;
+};
+
+} // namespace mdev::boostdep
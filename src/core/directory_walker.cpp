@@ -0,0 +1,207 @@
+#include "directory_walker.hpp"
+
+#include <system_error>
+
+// clang-format off
+#ifdef __linux__
+	#include <dirent.h>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+
+	#include <cerrno>
+	#include <cstddef>
+	#include <cstdint>
+	#include <cstring>
+#endif
+// clang-format on
+
+namespace fs = std::filesystem;
+
+namespace mdev {
+
+void DirectoryWalker::walk( const fs::path& dir, const Callback& on_file )
+{
+	visit( dir, on_file, nullptr );
+}
+
+void DirectoryWalker::list( const fs::path& dir, const Callback& on_file, const Callback& on_dir )
+{
+	visit( dir, on_file, &on_dir );
+}
+
+#ifdef __linux__
+
+namespace {
+
+// big enough for a typical directory in one call
+constexpr std::size_t dirent_buffer_size = 32 * 1024;
+
+// layout of the records returned by getdents64 (glibc doesn't expose the syscall itself)
+struct linux_dirent64 {
+	std::uint64_t  d_ino;
+	std::int64_t   d_off;
+	unsigned short d_reclen;
+	unsigned char  d_type;
+	char           d_name[1];
+};
+
+long sys_getdents64( int fd, char* buffer, std::size_t size )
+{
+	return ::syscall( SYS_getdents64, fd, buffer, size );
+}
+
+class FdGuard {
+public:
+	explicit FdGuard( int fd )
+		: _fd( fd )
+	{
+	}
+	FdGuard( const FdGuard& ) = delete;
+	FdGuard& operator=( const FdGuard& ) = delete;
+	~FdGuard()
+	{
+		if( _fd >= 0 ) {
+			::close( _fd );
+		}
+	}
+
+private:
+	int _fd;
+};
+
+[[noreturn]] void throw_error( const char* what, const std::string& path, int err )
+{
+	throw fs::filesystem_error( what, fs::path( path ), std::error_code( err, std::generic_category() ) );
+}
+
+constexpr int open_flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOCTTY;
+
+} // namespace
+
+void DirectoryWalker::visit( const fs::path& dir, const Callback& on_file, const Callback* on_dir )
+{
+	_path = dir.generic_string();
+	_pending.clear();
+
+	const int fd = ::open( _path.c_str(), open_flags );
+	if( fd < 0 ) {
+		throw_error( "opendir", _path, errno );
+	}
+	visit_fd( fd, on_file, on_dir );
+}
+
+// takes ownership of fd
+void DirectoryWalker::visit_fd( int fd, const Callback& on_file, const Callback* on_dir )
+{
+	FdGuard guard( fd );
+	_buffer.resize( dirent_buffer_size );
+
+	const auto dir_size      = _path.size();
+	const auto pending_begin = _pending.size();
+
+	for( ;; ) {
+		const long cnt = sys_getdents64( fd, _buffer.data(), _buffer.size() );
+		if( cnt < 0 ) {
+			throw_error( "getdents64", _path, errno );
+		}
+		if( cnt == 0 ) {
+			break;
+		}
+
+		for( long pos = 0; pos < cnt; ) {
+			const auto* entry = reinterpret_cast<const linux_dirent64*>( _buffer.data() + pos );
+			pos += entry->d_reclen;
+
+			const char* name = entry->d_name;
+			if( name[0] == '.' && ( name[1] == '\0' || ( name[1] == '.' && name[2] == '\0' ) ) ) {
+				continue;
+			}
+
+			unsigned char type = entry->d_type;
+			if( type == DT_UNKNOWN ) {
+				// some file systems don't fill in d_type
+				struct stat st;
+				if( ::fstatat( fd, name, &st, AT_SYMLINK_NOFOLLOW ) != 0 ) {
+					continue; // deleted in the meantime
+				}
+				if( S_ISDIR( st.st_mode ) ) {
+					type = DT_DIR;
+				} else if( S_ISREG( st.st_mode ) ) {
+					type = DT_REG;
+				} else if( S_ISLNK( st.st_mode ) ) {
+					type = DT_LNK;
+				}
+			}
+			if( type == DT_LNK ) {
+				// a symlink counts as a file if it points to one
+				struct stat st;
+				if( ::fstatat( fd, name, &st, 0 ) != 0 || !S_ISREG( st.st_mode ) ) {
+					continue;
+				}
+				type = DT_REG;
+			}
+
+			if( type == DT_REG ) {
+				_path += '/';
+				_path += name;
+				on_file( _path );
+				_path.resize( dir_size );
+			} else if( type == DT_DIR ) {
+				if( on_dir ) {
+					_path += '/';
+					_path += name;
+					( *on_dir )( _path );
+					_path.resize( dir_size );
+				} else {
+					// walked after this directory is done, so _buffer can be reused
+					_pending += name;
+					_pending += '\0';
+				}
+			}
+		}
+	}
+
+	for( auto pos = pending_begin; pos < _pending.size(); ) {
+		// _pending grows while walking the subdirectory, so only work with offsets here
+		const auto name_size = std::strlen( _pending.data() + pos );
+
+		const int sub_fd = ::openat( fd, _pending.data() + pos, open_flags );
+		if( sub_fd < 0 ) {
+			throw_error( "openat", _path + '/' + ( _pending.data() + pos ), errno );
+		}
+		_path += '/';
+		_path.append( _pending, pos, name_size );
+		visit_fd( sub_fd, on_file, on_dir );
+		_path.resize( dir_size );
+
+		pos += name_size + 1;
+	}
+	_pending.resize( pending_begin );
+}
+
+#else
+
+void DirectoryWalker::visit( const fs::path& dir, const Callback& on_file, const Callback* on_dir )
+{
+	for( const auto& entry : fs::directory_iterator( dir ) ) {
+		if( entry.is_directory() && !entry.is_symlink() ) {
+			_path = entry.path().generic_string();
+			if( on_dir ) {
+				( *on_dir )( _path );
+			} else {
+				visit( entry.path(), on_file, on_dir );
+			}
+		} else if( entry.is_regular_file() ) {
+			_path = entry.path().generic_string();
+			on_file( _path );
+		}
+	}
+}
+
+void DirectoryWalker::visit_fd( int, const Callback&, const Callback* ) {}
+
+#endif
+
+} // namespace mdev
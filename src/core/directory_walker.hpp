@@ -0,0 +1,43 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mdev {
+
+/**
+ * Lists the files below a directory without going through std::filesystem for every entry.
+ *
+ * On linux the entries are read in bulk (getdents64), the entry type is taken from d_type (no stat for most
+ * entries), subdirectories are opened relative to their parent (openat) and all paths are built in one
+ * reusable buffer. Other platforms use std::filesystem::directory_iterator.
+ *
+ * Paths are reported as dir + '/' + relative name (with '/' as separator, so they look like
+ * fs::path::generic_string()) and are only valid during the callback.
+ * Only regular files (or symlinks to them) are reported, symlinks to directories are not followed.
+ * Errors (e.g. a directory that can't be opened) are reported as std::filesystem::filesystem_error.
+ * An instance must only be used by one thread at a time.
+ */
+class DirectoryWalker {
+public:
+	using Callback = std::function<void( std::string_view path )>;
+
+	// Calls on_file for all files in dir and its subdirectories
+	void walk( const std::filesystem::path& dir, const Callback& on_file );
+
+	// Calls on_file for all files and on_dir for all subdirectories directly in dir
+	void list( const std::filesystem::path& dir, const Callback& on_file, const Callback& on_dir );
+
+private:
+	void visit( const std::filesystem::path& dir, const Callback& on_file, const Callback* on_dir );
+	void visit_fd( int fd, const Callback& on_file, const Callback* on_dir );
+
+	std::string       _path;    // path of the current directory, the names of its entries are appended temporarily
+	std::string       _pending; // '\0' terminated names of the subdirectories that still have to be walked
+	std::vector<char> _buffer;  // raw directory entries
+};
+
+} // namespace mdev
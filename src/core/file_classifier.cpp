@@ -0,0 +1,73 @@
+#include "file_classifier.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace mdev::boostdep {
+
+namespace {
+
+bool equals_ignore_case( std::string_view l, std::string_view r )
+{
+	const auto lower = []( char c ) { return c >= 'A' && c <= 'Z' ? static_cast<char>( c - 'A' + 'a' ) : c; };
+	return l.size() == r.size()
+		   && std::equal( l.begin(), l.end(), r.begin(), [&]( char a, char b ) { return lower( a ) == lower( b ); } );
+}
+
+bool contains_ignore_case( const std::vector<String_t>& list, std::string_view str )
+{
+	return std::any_of( list.begin(), list.end(), [&]( const auto& e ) { return equals_ignore_case( e, str ); } );
+}
+
+} // namespace
+
+FileClass FileClassifier::classify( std::string_view path ) const
+{
+	const auto slash = path.find_last_of( "/\\" );
+	const auto name  = slash == std::string_view::npos ? path : path.substr( slash + 1 );
+
+	if( std::find( skipped_names.begin(), skipped_names.end(), name ) != skipped_names.end() ) {
+		return FileClass::Skipped;
+	}
+
+	const auto dot = name.rfind( '.' );
+	if( dot == std::string_view::npos || dot == 0 ) {
+		return FileClass::Unknown;
+	}
+	const auto ext = name.substr( dot );
+	if( contains_ignore_case( source_extensions, ext ) ) {
+		return FileClass::Source;
+	}
+	if( contains_ignore_case( skipped_extensions, ext ) ) {
+		return FileClass::Skipped;
+	}
+	return FileClass::Unknown;
+}
+
+bool FileClassifier::is_skipped_content( std::string_view head ) const
+{
+	for( const auto& magic : skipped_magic ) {
+		if( head.substr( 0, magic.size() ) == magic ) {
+			return true;
+		}
+	}
+	return skip_binary && head.substr( 0, sniff_size ).find( '\0' ) != std::string_view::npos;
+}
+
+bool FileClassifier::is_skipped( std::string_view path ) const
+{
+	switch( classify( path ) ) {
+		case FileClass::Source: return false;
+		case FileClass::Skipped: return true;
+		case FileClass::Unknown: break;
+	}
+
+	String_t      head( sniff_size, '\0' );
+	std::ifstream in( std::filesystem::path( path ), std::ios::binary );
+	in.read( head.data(), static_cast<std::streamsize>( head.size() ) );
+	head.resize( static_cast<std::size_t>( in.gcount() ) );
+	return is_skipped_content( head );
+}
+
+} // namespace mdev::boostdep
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "utils.hpp"
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace mdev::boostdep {
+
+enum class FileClass {
+	Source,  // parse it
+	Skipped, // can't contain an include, don't even read it
+	Unknown  // decide based on the first bytes of the content
+};
+
+/**
+ * Decides which files can contain includes and have to be parsed at all.
+ *
+ * Looks at the file name first (extensions are compared case insensitive and include the dot).
+ * Files with an unknown extension (or none at all, like the <cstdio> wrappers in boost/compatibility)
+ * are parsed, unless their content starts with one of the magic byte sequences or looks binary.
+ * The default rules cover the usual c++ files and what else lives in boost's src and test directories
+ * (build files, docs, images, test data ...), but all of them can be changed.
+ */
+struct FileClassifier {
+	std::vector<String_t> source_extensions{
+		".hpp", ".h", ".ipp", ".cpp", ".cxx", ".cc", ".c", ".hxx", ".hh", ".inl", ".inc", ".tpp", ".ixx"};
+
+	std::vector<String_t> skipped_extensions{
+		".txt", ".md", ".qbk", ".html", ".htm", ".xml", ".xsl", ".css", ".js", ".json", ".yml", ".yaml", ".rst",
+		".png", ".jpg", ".jpeg", ".gif", ".svg", ".bmp", ".ico", ".pdf", ".ps", ".eps", ".dot", ".jam", ".py",
+		".sh", ".bat", ".cmd", ".cmake", ".dat", ".bin", ".csv", ".log", ".gz", ".bz2", ".xz", ".zip", ".7z", ".tar"};
+
+	// complete file names, e.g. build files without an extension
+	std::vector<String_t> skipped_names{"Jamfile", "Jamfile.v2", "Jamroot", "Makefile", "CMakeLists.txt", ".gitignore"};
+
+	// prefixes of binary formats
+	std::vector<String_t> skipped_magic{
+		"\x89PNG", "GIF8", "\xFF\xD8\xFF", "%PDF", "PK\x03\x04", "\x1F\x8B", "\x7F" "ELF", "BZh", "\xFD" "7zXZ"};
+
+	// also skip files of unknown type with a '\0' in the first sniff_size bytes
+	bool skip_binary = true;
+
+	std::size_t sniff_size = 512;
+
+	// path may be a full path or just a file name
+	FileClass classify( std::string_view path ) const;
+
+	// head: (at least) the first sniff_size bytes of a file with FileClass::Unknown
+	bool is_skipped_content( std::string_view head ) const;
+
+	// Same as classify, but also reads the beginning of files with an unknown type
+	bool is_skipped( std::string_view path ) const;
+};
+
+} // namespace mdev::boostdep
@@ -0,0 +1,476 @@
+#include "file_graph.hpp"
+
+#include "binary_io.hpp"
+#include "bitset.hpp"
+#include "dependency_maps.hpp"
+#include "mapped_file.hpp"
+#include "module_sets.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <type_traits>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace mdev::boostdep {
+
+namespace {
+
+//################### Construction #####################################
+
+class GraphBuilder {
+public:
+	// The string_views have to stay valid until finish() is called
+	template<class Rng>
+	void add_file( std::string_view name, std::string_view module_name, FileCategory category, const Rng& includes )
+	{
+		_graph.names.push_back( add_string( name ) );
+		_graph.modules.push_back( add_string( module_name ) );
+		_graph.categories.push_back( category );
+		for( std::string_view inc : includes ) {
+			_graph.edge_names.push_back( add_string( inc ) );
+		}
+		_graph.offsets.push_back( static_cast<std::uint32_t>( _graph.edge_names.size() ) );
+	}
+
+	FileGraph finish()
+	{
+		// string id -> file with that name
+		std::vector<FileId> files_by_name( _graph.string_count(), unresolved_file );
+		for( FileId f = static_cast<FileId>( _graph.file_count() ); f-- > 0; ) {
+			files_by_name[_graph.names[f]] = f; // iterating backwards, so the first file wins
+		}
+
+		_graph.edges.reserve( _graph.edge_names.size() );
+		for( auto name : _graph.edge_names ) {
+			_graph.edges.push_back( files_by_name[name] );
+		}
+		return std::move( _graph );
+	}
+
+private:
+	StringId add_string( std::string_view str )
+	{
+		const auto [it, inserted] = _ids.try_emplace( str, static_cast<StringId>( _graph.string_count() ) );
+		if( inserted ) {
+			_graph.string_data.insert( _graph.string_data.end(), str.begin(), str.end() );
+			_graph.string_offsets.push_back( static_cast<std::uint32_t>( _graph.string_data.size() ) );
+		}
+		return it->second;
+	}
+
+	FileGraph                                     _graph;
+	std::unordered_map<std::string_view, StringId> _ids;
+};
+
+//################### Serialization #####################################
+
+constexpr std::uint32_t graph_format_version = 2;
+constexpr char          graph_magic[8]       = {'B', 'D', 'G', 'G', 'R', 'A', 'P', 'H'};
+constexpr std::size_t   graph_header_size    = sizeof( graph_magic ) + 2 * sizeof( std::uint32_t );
+
+static_assert( graph_header_size % binary_alignment == 0 );
+
+template<class T>
+bool all_below( const std::vector<T>& ids, std::size_t limit )
+{
+	return std::all_of( ids.begin(), ids.end(), [limit]( T id ) { return id < limit; } );
+}
+
+bool is_valid_offset_table( const std::vector<std::uint32_t>& offsets, std::size_t data_size )
+{
+	return !offsets.empty() && offsets.front() == 0 && offsets.back() == data_size
+		   && std::is_sorted( offsets.begin(), offsets.end() );
+}
+
+bool is_valid_category( FileCategory category )
+{
+	using Underlying = std::underlying_type_t<FileCategory>;
+	const auto value = static_cast<Underlying>( category );
+	return value >= static_cast<Underlying>( FileCategory::Unknown )
+		   && value <= static_cast<Underlying>( FileCategory::Test );
+}
+
+//################### Analysis #####################################
+
+// View for the shared analysis in dependency_maps.hpp: the includes were already resolved by make_file_graph
+class GraphFiles {
+public:
+	using Id                                    = FileId;
+	static constexpr std::size_t files_per_task = 1024;
+
+	explicit GraphFiles( const FileGraph& graph )
+		: _graph( graph )
+	{
+	}
+
+	std::size_t      size() const { return _graph.file_count(); }
+	std::string_view name( Id file ) const { return _graph.name( file ); }
+	std::string_view module_name( Id file ) const { return _graph.module_name( file ); }
+
+	template<class Resolved, class Unresolved>
+	void for_each_include( Id file, Resolved&& resolved, Unresolved&& unresolved ) const
+	{
+		const auto includes = _graph.includes( file );
+		for( std::size_t i = 0; i < includes.size(); ++i ) {
+			if( includes[i] != unresolved_file ) {
+				resolved( includes[i] );
+			} else {
+				unresolved( _graph.string( _graph.include_names( file )[i] ) );
+			}
+		}
+	}
+
+private:
+	const FileGraph& _graph;
+};
+
+std::vector<FileId> filter_files( const FileGraph& graph, std::string_view root_module, AnalysisStats* stats )
+{
+	ScopedTimer timer( stats ? &stats->filter_time : nullptr );
+	return filter_files( graph, root_module );
+}
+
+//################### Batch analysis #####################################
+
+struct Components {
+	std::vector<std::uint32_t> of_file; // component of each file
+	std::vector<std::uint32_t> offsets; // files of component c are files[offsets[c]] ... files[offsets[c+1]-1]
+	std::vector<FileId>        files;
+
+	std::size_t        size() const { return offsets.size() - 1; }
+	span<const FileId> members( std::uint32_t c ) const
+	{
+		return {files.data() + offsets[c], offsets[c + 1] - offsets[c]};
+	}
+};
+
+/*
+ * Strongly connected components of the include graph (Tarjan's algorithm without recursion, boost has include
+ * chains that are deep enough to make that a concern).
+ * Components are numbered in reverse topological order: files only include files of the same or a lower component
+ */
+Components find_components( const FileGraph& graph )
+{
+	constexpr std::uint32_t unvisited = ~std::uint32_t{0};
+
+	const auto                 file_cnt = graph.file_count();
+	std::vector<std::uint32_t> index( file_cnt, unvisited );
+	std::vector<std::uint32_t> lowlink( file_cnt, 0 );
+
+	Components ret;
+	ret.of_file.assign( file_cnt, unvisited );
+
+	struct Frame {
+		FileId      file;
+		std::size_t next_include;
+	};
+	std::vector<Frame>  call_stack;
+	std::vector<FileId> stack;
+	std::uint32_t       counter       = 0;
+	std::uint32_t       component_cnt = 0;
+
+	const auto push = [&]( FileId f ) {
+		index[f] = lowlink[f] = counter++;
+		stack.push_back( f );
+		call_stack.push_back( {f, 0} );
+	};
+
+	for( FileId start = 0; start < file_cnt; ++start ) {
+		if( index[start] != unvisited ) {
+			continue;
+		}
+		push( start );
+		while( !call_stack.empty() ) {
+			auto&      frame    = call_stack.back();
+			const auto includes = graph.includes( frame.file );
+			if( frame.next_include < includes.size() ) {
+				const auto inc = includes[frame.next_include++];
+				if( inc == unresolved_file ) {
+					continue;
+				}
+				if( index[inc] == unvisited ) {
+					push( inc ); // invalidates frame
+				} else if( ret.of_file[inc] == unvisited ) { // inc is still on the stack
+					lowlink[frame.file] = std::min( lowlink[frame.file], index[inc] );
+				}
+				continue;
+			}
+
+			const auto file = frame.file;
+			call_stack.pop_back();
+			if( !call_stack.empty() ) {
+				auto& parent_low = lowlink[call_stack.back().file];
+				parent_low       = std::min( parent_low, lowlink[file] );
+			}
+			if( lowlink[file] == index[file] ) {
+				FileId member;
+				do {
+					member = stack.back();
+					stack.pop_back();
+					ret.of_file[member] = component_cnt;
+				} while( member != file );
+				component_cnt++;
+			}
+		}
+	}
+
+	// group the files by component
+	ret.offsets.assign( component_cnt + 1, 0 );
+	for( const auto c : ret.of_file ) {
+		ret.offsets[c + 1]++;
+	}
+	for( std::size_t c = 0; c < component_cnt; ++c ) {
+		ret.offsets[c + 1] += ret.offsets[c];
+	}
+	ret.files.resize( file_cnt );
+	auto next = ret.offsets;
+	for( FileId f = 0; f < file_cnt; ++f ) {
+		ret.files[next[ret.of_file[f]]++] = f;
+	}
+	return ret;
+}
+
+} // namespace
+
+void FileGraph::write_arrays( std::ostream& os ) const
+{
+	write_array( os, string_data );
+	write_array( os, string_offsets );
+	write_array( os, names );
+	write_array( os, modules );
+	write_array( os, categories );
+	write_array( os, offsets );
+	write_array( os, edges );
+	write_array( os, edge_names );
+}
+
+bool FileGraph::read_arrays( std::string_view& data )
+{
+	FileGraph  g;
+	const bool ok = read_array( data, g.string_data ) && read_array( data, g.string_offsets )
+					&& read_array( data, g.names ) && read_array( data, g.modules ) && read_array( data, g.categories )
+					&& read_array( data, g.offsets ) && read_array( data, g.edges ) && read_array( data, g.edge_names );
+	if( !ok || !g.is_consistent() ) {
+		return false;
+	}
+	*this = std::move( g );
+	return true;
+}
+
+bool FileGraph::save( const fs::path& file ) const
+{
+	std::ofstream os( file, std::ios::binary | std::ios::trunc );
+	if( !os ) {
+		return false;
+	}
+	const std::uint32_t reserved = 0;
+	os.write( graph_magic, sizeof( graph_magic ) );
+	os.write( reinterpret_cast<const char*>( &graph_format_version ), sizeof( graph_format_version ) );
+	os.write( reinterpret_cast<const char*>( &reserved ), sizeof( reserved ) );
+	write_arrays( os );
+	return static_cast<bool>( os );
+}
+
+bool FileGraph::load( const fs::path& file )
+{
+	const MappedFile mapping( file );
+	auto             data = mapping.content();
+
+	if( data.size() < graph_header_size
+		|| data.substr( 0, sizeof( graph_magic ) ) != std::string_view( graph_magic, sizeof( graph_magic ) ) ) {
+		return false;
+	}
+	std::uint32_t version = 0;
+	std::memcpy( &version, data.data() + sizeof( graph_magic ), sizeof( version ) );
+	if( version != graph_format_version ) {
+		return false;
+	}
+	data.remove_prefix( graph_header_size );
+	return read_arrays( data );
+}
+
+bool FileGraph::is_consistent() const
+{
+	const auto& g        = *this;
+	const auto  file_cnt = g.file_count();
+	return is_valid_offset_table( g.string_offsets, g.string_data.size() )
+		   && is_valid_offset_table( g.offsets, g.edges.size() ) //
+		   && g.modules.size() == file_cnt && g.categories.size() == file_cnt && g.offsets.size() == file_cnt + 1
+		   && g.edge_names.size() == g.edges.size() //
+		   && all_below( g.names, g.string_count() ) && all_below( g.modules, g.string_count() )
+		   && all_below( g.edge_names, g.string_count() )
+		   && std::all_of( g.categories.begin(), g.categories.end(), is_valid_category )
+		   && std::all_of( g.edges.begin(), g.edges.end(), [&]( FileId f ) {
+				  return f == unresolved_file || f < file_cnt;
+			  } );
+}
+
+std::size_t FileGraph::memory_usage() const
+{
+	return string_data.size() + string_offsets.size() * sizeof( std::uint32_t ) + names.size() * sizeof( StringId )
+		   + modules.size() * sizeof( StringId ) + categories.size() * sizeof( FileCategory )
+		   + offsets.size() * sizeof( std::uint32_t ) + edges.size() * sizeof( FileId )
+		   + edge_names.size() * sizeof( StringId );
+}
+
+FileGraph make_file_graph( const std::vector<FileInfo>& files )
+{
+	GraphBuilder builder;
+	for( const auto& f : files ) {
+		builder.add_file( f.name, f.module_name, f.category, f.included_files );
+	}
+	return builder.finish();
+}
+
+FileGraph make_file_graph( const std::vector<InternedFileInfo>& files, const StringPool& pool )
+{
+	GraphBuilder                  builder;
+	std::vector<std::string_view> includes;
+	for( const auto& f : files ) {
+		includes.clear();
+		for( const auto inc : f.included_files ) {
+			includes.push_back( pool.view( inc ) );
+		}
+		builder.add_file( pool.view( f.name ), pool.view( f.module_name ), f.category, includes );
+	}
+	return builder.finish();
+}
+
+std::vector<FileInfo> to_file_infos( const FileGraph& graph )
+{
+	std::vector<FileInfo> ret;
+	ret.reserve( graph.file_count() );
+	for( FileId f = 0; f < graph.file_count(); ++f ) {
+		FileInfo info;
+		info.name        = String_t( graph.name( f ) );
+		info.module_name = String_t( graph.module_name( f ) );
+		info.category    = graph.categories[f];
+		for( const auto inc : graph.include_names( f ) ) {
+			info.included_files.emplace_back( graph.string( inc ) );
+		}
+		ret.push_back( std::move( info ) );
+	}
+	return ret;
+}
+
+std::vector<FileId> filter_files( const FileGraph& graph, std::string_view root_module )
+{
+	return reachable_files( GraphFiles( graph ), root_module );
+}
+
+DependencyGraph build_module_dependency_map( const FileGraph& graph, AnalysisStats* stats )
+{
+	AnalysisScope    scope( stats, graph.file_count() );
+	const GraphFiles files( graph );
+	return scope.done( to_default_format( make_module_dep_map( files, all_files( files ), stats ) ) );
+}
+
+DependencyGraph
+build_filtered_module_dependency_map( const FileGraph& graph, std::string_view root_module, AnalysisStats* stats )
+{
+	AnalysisScope scope( stats, graph.file_count() );
+	const auto    filtered = filter_files( graph, root_module, stats );
+	return scope.done( to_default_format( make_module_dep_map( GraphFiles( graph ), filtered, stats ) ) );
+}
+
+DependencyGraph
+build_filtered_file_dependency_map( const FileGraph& graph, std::string_view root_module, AnalysisStats* stats )
+{
+	AnalysisScope scope( stats, graph.file_count() );
+	const auto    filtered = filter_files( graph, root_module, stats );
+	return scope.done( make_filtered_file_dep_map( GraphFiles( graph ), filtered, root_module, stats ) );
+}
+
+/*
+ * Instead of following the includes from every root module separately, this computes for every strongly connected
+ * component of the include graph the set of root modules that reach it. As components only include components with
+ * a lower number, that is a single pass over the components from the highest to the lowest number, which ORs the
+ * root set of each component into all the components it includes.
+ * Then every include edge contributes its (module, included module) pair to the result of all roots that reach the
+ * file it is in.
+ */
+std::map<String_t, DependencyGraph> build_all_filtered_module_dependency_maps( const FileGraph& graph,
+																			  AnalysisStats*   stats )
+{
+	ScopedTimer timer( stats ? &stats->total : nullptr );
+	if( stats ) {
+		stats->files += graph.file_count();
+	}
+
+	const auto modules    = number_modules( GraphFiles( graph ) );
+	const auto module_cnt = modules.names.size();
+
+	// roots[c]: modules whose files (directly or indirectly) include the files in component c
+	std::vector<DynamicBitset> roots;
+	const auto                 components = [&] {
+		ScopedTimer filter_timer( stats ? &stats->filter_time : nullptr );
+
+		auto ret = find_components( graph );
+		roots.assign( ret.size(), DynamicBitset( module_cnt ) );
+		for( FileId f = 0; f < graph.file_count(); ++f ) {
+			roots[ret.of_file[f]].set( modules.of_file[f] );
+		}
+		for( auto c = static_cast<std::uint32_t>( ret.size() ); c-- > 0; ) {
+			for( const auto f : ret.members( c ) ) {
+				for( const auto inc : graph.includes( f ) ) {
+					if( inc != unresolved_file && ret.of_file[inc] != c ) {
+						roots[ret.of_file[inc]].merge( roots[c] );
+					}
+				}
+			}
+		}
+		return ret;
+	}();
+
+	ScopedTimer dep_map_timer( stats ? &stats->dep_map_time : nullptr );
+
+	// deps[root]: the result for root (allocated when the first file is reached from root)
+	std::vector<ModuleSets>    deps( module_cnt );
+	std::vector<std::uint32_t> included_modules;
+	for( FileId f = 0; f < graph.file_count(); ++f ) {
+		const auto module = modules.of_file[f];
+
+		included_modules.clear();
+		for( const auto inc : graph.includes( f ) ) {
+			if( inc != unresolved_file && modules.of_file[inc] != module ) {
+				included_modules.push_back( modules.of_file[inc] );
+			}
+		}
+
+		roots[components.of_file[f]].for_each( [&]( std::size_t root ) {
+			auto& root_deps = deps[root];
+			if( root_deps.module_count() == 0 ) {
+				root_deps = ModuleSets( module_cnt );
+			}
+			auto& module_deps = root_deps.add_module( module );
+			for( const auto m : included_modules ) {
+				module_deps.set( m );
+			}
+		} );
+	}
+
+	std::map<String_t, DependencyGraph> ret;
+	for( std::size_t root = 0; root < module_cnt; ++root ) {
+		auto& graph = ret[String_t( modules.names[root] )];
+		if( deps[root].module_count() != 0 ) {
+			graph = deps[root].to_dependency_graph( modules.names );
+		}
+		if( stats ) {
+			stats->nodes += graph.size();
+		}
+	}
+	return ret;
+}
+
+std::map<String_t, DependencyGraph> build_all_filtered_module_dependency_maps( const std::vector<FileInfo>& files,
+																			  AnalysisStats*               stats )
+{
+	return build_all_filtered_module_dependency_maps( make_file_graph( files ), stats );
+}
+
+} // namespace mdev::boostdep
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "boostdep.hpp"
+#include "string_pool.hpp"
+#include "utils.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace mdev::boostdep {
+
+using FileId   = std::uint32_t;
+using StringId = std::uint32_t; // index into the string table of a FileGraph
+
+// Target of an include that doesn't refer to any scanned file
+constexpr FileId unresolved_file = ~FileId{0};
+
+/**
+ * Compact representation of the scan result (compressed sparse row format):
+ *
+ * File ids are indices into names/modules/categories. The includes of file i are
+ * edges[offsets[i]] ... edges[offsets[i+1]-1] (in the order they appear in the file)
+ * and edge_names holds the included name for every edge, so unresolved includes don't get lost.
+ * All strings are stored once in a string table that is owned by the graph.
+ *
+ * Everything lives in a handful of flat arrays, which is much more cache friendly than
+ * std::vector<FileInfo> and can be written to / read from disk in one go.
+ */
+struct FileGraph {
+	// string i is string_data[string_offsets[i]] ... string_data[string_offsets[i+1]-1]
+	std::vector<char>          string_data;
+	std::vector<std::uint32_t> string_offsets{0};
+
+	std::vector<StringId>     names;
+	std::vector<StringId>     modules;
+	std::vector<FileCategory> categories;
+
+	std::vector<std::uint32_t> offsets{0};
+	std::vector<FileId>        edges;
+	std::vector<StringId>      edge_names;
+
+	std::size_t file_count() const { return names.size(); }
+	std::size_t string_count() const { return string_offsets.size() - 1; }
+
+	std::string_view string( StringId id ) const
+	{
+		return {string_data.data() + string_offsets[id], string_offsets[id + 1] - string_offsets[id]};
+	}
+	std::string_view name( FileId file ) const { return string( names[file] ); }
+	std::string_view module_name( FileId file ) const { return string( modules[file] ); }
+
+	span<const FileId> includes( FileId file ) const
+	{
+		return {edges.data() + offsets[file], offsets[file + 1] - offsets[file]};
+	}
+	span<const StringId> include_names( FileId file ) const
+	{
+		return {edge_names.data() + offsets[file], offsets[file + 1] - offsets[file]};
+	}
+
+	// Returns false if the file doesn't exist or has an incompatible format
+	bool save( const std::filesystem::path& file ) const;
+	bool load( const std::filesystem::path& file );
+
+	// The arrays in the format of binary_io.hpp, for files that embed a graph (like ScanSnapshot).
+	// read_arrays consumes them from the front of data and returns false (*this unchanged) if they are corrupt
+	void write_arrays( std::ostream& os ) const;
+	bool read_arrays( std::string_view& data );
+
+	// Makes sure a graph read from disk can't cause out of bounds accesses
+	bool is_consistent() const;
+
+	// number of bytes used by the arrays
+	std::size_t memory_usage() const;
+};
+
+// If several files have the same name, includes refer to the first one
+FileGraph make_file_graph( const std::vector<FileInfo>& files );
+FileGraph make_file_graph( const std::vector<InternedFileInfo>& files, const StringPool& pool = global_string_pool() );
+
+std::vector<FileInfo> to_file_infos( const FileGraph& graph );
+
+// Returns all files that are directly or indirectly included from a file in root_module (including those files)
+std::vector<FileId> filter_files( const FileGraph& graph, std::string_view root_module );
+
+// Same as the FileInfo based versions, but the includes were already resolved by make_file_graph,
+// so the queries only follow integer edges
+DependencyGraph build_module_dependency_map( const FileGraph& graph, AnalysisStats* stats = nullptr );
+DependencyGraph build_filtered_module_dependency_map( const FileGraph& graph,
+													  std::string_view root_module,
+													  AnalysisStats*   stats = nullptr );
+DependencyGraph build_filtered_file_dependency_map( const FileGraph& graph,
+													std::string_view root_module,
+													AnalysisStats*   stats = nullptr );
+
+// root module -> build_filtered_module_dependency_map( files, root module ), for all modules at once.
+// Much faster than separate calls, because the parts of the include graph that many modules reach are only
+// processed once. Unresolved includes are ignored
+std::map<String_t, DependencyGraph> build_all_filtered_module_dependency_maps( const FileGraph& graph,
+																			  AnalysisStats*   stats = nullptr );
+std::map<String_t, DependencyGraph> build_all_filtered_module_dependency_maps( const std::vector<FileInfo>& files,
+																			  AnalysisStats*               stats = nullptr );
+
+} // namespace mdev::boostdep
@@ -0,0 +1,56 @@
+#include "file_index.hpp"
+
+#include <stdexcept>
+
+namespace mdev::boostdep {
+
+FileIndex::FileIndex( const std::vector<FileInfo>& files )
+	: _files( &files )
+{
+	if( files.size() >= empty_slot ) {
+		throw std::length_error( "Too many files for FileIndex" );
+	}
+
+	// at most half of the slots are used, which keeps the probe sequences short
+	std::size_t capacity = 16;
+	while( capacity < files.size() * 2 ) {
+		capacity *= 2;
+	}
+	_slots.resize( capacity );
+	_mask = capacity - 1;
+
+	for( std::size_t i = 0; i < files.size(); ++i ) {
+		const auto hash = hash64( files[i].name );
+		const auto tag  = static_cast<std::uint32_t>( hash >> 32 );
+		for( auto idx = static_cast<std::size_t>( hash ) & _mask;; idx = ( idx + 1 ) & _mask ) {
+			auto& slot = _slots[idx];
+			if( slot.position == empty_slot ) {
+				slot = {tag, static_cast<std::uint32_t>( i )};
+				break;
+			}
+			if( slot.hash == tag && files[slot.position].name == files[i].name ) {
+				break; // the first file with that name wins
+			}
+		}
+	}
+}
+
+std::size_t FileIndex::find( std::string_view name ) const
+{
+	if( _slots.empty() ) {
+		return npos;
+	}
+	const auto hash = hash64( name );
+	const auto tag  = static_cast<std::uint32_t>( hash >> 32 );
+	for( auto idx = static_cast<std::size_t>( hash ) & _mask;; idx = ( idx + 1 ) & _mask ) {
+		const auto& slot = _slots[idx];
+		if( slot.position == empty_slot ) {
+			return npos;
+		}
+		if( slot.hash == tag && ( *_files )[slot.position].name == name ) {
+			return slot.position;
+		}
+	}
+}
+
+} // namespace mdev::boostdep
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "boostdep.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace mdev::boostdep {
+
+/**
+ * Finds files of a scan result by name (open addressing with linear probing, the slots store part of the hash, so
+ * a lookup almost never compares more than one string).
+ *
+ * Build it once per scan result and use it for all queries on that result. The index refers to the vector it was
+ * built from, so it has to be rebuilt whenever that vector changes (e.g. after rescan_paths).
+ */
+class FileIndex {
+public:
+	static constexpr std::size_t npos = ~std::size_t{0};
+
+	FileIndex() = default;
+	explicit FileIndex( const std::vector<FileInfo>& files );
+	explicit FileIndex( std::vector<FileInfo>&& files ) = delete; // the index would refer to a temporary
+
+	// Position of the file with that name in files (the first one, if there are several) or npos
+	std::size_t find( std::string_view name ) const;
+
+	// empty for a default constructed index
+	const std::vector<FileInfo>& files() const { return *_files; }
+
+private:
+	static constexpr std::uint32_t empty_slot = ~std::uint32_t{0};
+
+	struct Slot {
+		std::uint32_t hash     = 0; // upper half of the 64 bit hash (the lower half selects the slot)
+		std::uint32_t position = empty_slot;
+	};
+
+	static inline const std::vector<FileInfo> no_files{};
+
+	const std::vector<FileInfo>* _files = &no_files;
+	std::vector<Slot>            _slots;
+	std::size_t                  _mask = 0;
+};
+
+} // namespace mdev::boostdep
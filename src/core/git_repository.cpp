@@ -0,0 +1,650 @@
+#include "git_repository.hpp"
+
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef BDG_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace mdev::git {
+
+namespace {
+
+constexpr std::size_t id_size = 20;
+
+[[noreturn]] void fail( const std::string& msg )
+{
+	throw std::runtime_error( "git: " + msg );
+}
+
+int hex_value( char c )
+{
+	if( c >= '0' && c <= '9' ) return c - '0';
+	if( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+	if( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+	return -1;
+}
+
+std::uint32_t read_be32( const unsigned char* p )
+{
+	return ( std::uint32_t( p[0] ) << 24 ) | ( std::uint32_t( p[1] ) << 16 ) | ( std::uint32_t( p[2] ) << 8 )
+		   | std::uint32_t( p[3] );
+}
+
+std::string read_text_file( const fs::path& file )
+{
+	std::ifstream      is( file, std::ios::binary );
+	std::ostringstream ss;
+	ss << is.rdbuf();
+	return ss.str();
+}
+
+std::string_view trim( std::string_view str )
+{
+	const auto first = str.find_first_not_of( " \t\r\n" );
+	if( first == std::string_view::npos ) {
+		return {};
+	}
+	const auto last = str.find_last_not_of( " \t\r\n" );
+	return str.substr( first, last - first + 1 );
+}
+
+// Inflates a zlib stream that starts at the beginning of data. Any data after the end of the stream is ignored.
+// If the size of the result is known (e.g. from a pack entry header), streams that inflate to anything else are corrupt
+std::string inflate( std::string_view data, std::optional<std::size_t> size )
+{
+#ifdef BDG_HAS_ZLIB
+	// data may be the rest of a huge pack file, so the guess is only a starting point
+	constexpr std::size_t max_guess = std::size_t{1} << 20;
+
+	// one byte more than expected, so a stream that is too long gets noticed
+	std::string out( size ? *size + 1 : std::min( data.size() * 3 + 64, max_guess ), '\0' );
+
+	z_stream zs{};
+	if( inflateInit( &zs ) != Z_OK ) {
+		fail( "inflateInit failed" );
+	}
+	zs.next_in  = reinterpret_cast<Bytef*>( const_cast<char*>( data.data() ) );
+	zs.avail_in = static_cast<uInt>( std::min<std::size_t>( data.size(), UINT32_MAX ) );
+
+	int ret = Z_OK;
+	while( ret != Z_STREAM_END ) {
+		if( zs.total_out == out.size() ) {
+			if( size ) {
+				inflateEnd( &zs );
+				fail( "object is larger than its header says" );
+			}
+			out.resize( out.size() * 2 );
+		}
+		zs.next_out  = reinterpret_cast<Bytef*>( out.data() + zs.total_out );
+		zs.avail_out = static_cast<uInt>( out.size() - zs.total_out );
+
+		ret = ::inflate( &zs, Z_NO_FLUSH );
+		if( ret != Z_OK && ret != Z_STREAM_END ) {
+			inflateEnd( &zs );
+			fail( "corrupt zlib stream" );
+		}
+	}
+	const std::size_t produced = zs.total_out;
+	inflateEnd( &zs );
+	if( size && produced != *size ) {
+		fail( "object is smaller than its header says" );
+	}
+	out.resize( produced );
+	return out;
+#else
+	(void)data;
+	(void)size;
+	fail( "built without zlib support" );
+#endif
+}
+
+std::size_t read_delta_size( std::string_view delta, std::size_t& pos )
+{
+	std::size_t   size  = 0;
+	int           shift = 0;
+	unsigned char c     = 0;
+	do {
+		if( pos >= delta.size() ) {
+			fail( "corrupt delta" );
+		}
+		c = static_cast<unsigned char>( delta[pos++] );
+		size |= std::size_t( c & 0x7f ) << shift;
+		shift += 7;
+	} while( c & 0x80 );
+	return size;
+}
+
+std::string apply_delta( std::string_view base, std::string_view delta )
+{
+	std::size_t pos = 0;
+	if( read_delta_size( delta, pos ) != base.size() ) {
+		fail( "delta base has the wrong size" );
+	}
+	const auto result_size = read_delta_size( delta, pos );
+
+	std::string result;
+	result.reserve( result_size );
+	while( pos < delta.size() ) {
+		const auto cmd = static_cast<unsigned char>( delta[pos++] );
+		if( cmd & 0x80 ) { // copy from base
+			std::size_t offset = 0;
+			std::size_t size   = 0;
+			for( int i = 0; i < 4; ++i ) {
+				if( cmd & ( 1 << i ) ) {
+					offset |= std::size_t( static_cast<unsigned char>( delta.at( pos++ ) ) ) << ( 8 * i );
+				}
+			}
+			for( int i = 0; i < 3; ++i ) {
+				if( cmd & ( 0x10 << i ) ) {
+					size |= std::size_t( static_cast<unsigned char>( delta.at( pos++ ) ) ) << ( 8 * i );
+				}
+			}
+			if( size == 0 ) {
+				size = 0x10000;
+			}
+			if( offset + size > base.size() ) {
+				fail( "corrupt delta" );
+			}
+			result.append( base.data() + offset, size );
+		} else if( cmd != 0 ) { // insert literal data
+			if( pos + cmd > delta.size() ) {
+				fail( "corrupt delta" );
+			}
+			result.append( delta.data() + pos, cmd );
+			pos += cmd;
+		} else {
+			fail( "corrupt delta" );
+		}
+	}
+	if( result.size() != result_size ) {
+		fail( "corrupt delta" );
+	}
+	return result;
+}
+
+} // namespace
+
+//################### ObjectId #####################################
+
+std::optional<ObjectId> ObjectId::from_hex( std::string_view hex )
+{
+	if( hex.size() != 2 * id_size ) {
+		return {};
+	}
+	ObjectId id;
+	for( std::size_t i = 0; i < id_size; ++i ) {
+		const int hi = hex_value( hex[2 * i] );
+		const int lo = hex_value( hex[2 * i + 1] );
+		if( hi < 0 || lo < 0 ) {
+			return {};
+		}
+		id.bytes[i] = static_cast<unsigned char>( hi * 16 + lo );
+	}
+	return id;
+}
+
+std::string ObjectId::to_hex() const
+{
+	constexpr char digits[] = "0123456789abcdef";
+
+	std::string ret;
+	for( auto b : bytes ) {
+		ret += digits[b >> 4];
+		ret += digits[b & 0xf];
+	}
+	return ret;
+}
+
+//################### Packfiles #####################################
+
+class Repository::Pack {
+public:
+	Pack( const Repository& repo, const fs::path& idx_file )
+		: _repo( repo )
+		, _idx( idx_file )
+		, _pack( fs::path( idx_file ).replace_extension( ".pack" ) )
+	{
+		const auto idx = _idx.content();
+		// magic + version + fanout table
+		if( idx.size() < 8 + 256 * 4 || idx.substr( 0, 4 ) != "\377tOc" || read_be32( bytes( idx, 4 ) ) != 2 ) {
+			fail( "unsupported pack index " + idx_file.string() );
+		}
+		_fanout = bytes( idx, 8 );
+		_count  = read_be32( _fanout + 255 * 4 );
+
+		const std::size_t ids_pos = 8 + 256 * 4;
+		const std::size_t ofs_pos = ids_pos + _count * ( id_size + 4 ); // skip ids and crc32s
+		if( idx.size() < ofs_pos + _count * 4 || _pack.content().substr( 0, 4 ) != "PACK" ) {
+			fail( "corrupt pack " + idx_file.string() );
+		}
+		_ids       = bytes( idx, ids_pos );
+		_offsets   = bytes( idx, ofs_pos );
+		_offsets64 = bytes( idx, ofs_pos + _count * 4 );
+		_idx_end   = reinterpret_cast<const unsigned char*>( idx.data() + idx.size() );
+	}
+
+	std::optional<std::uint64_t> find( const ObjectId& id ) const
+	{
+		const auto    first = id.bytes[0];
+		std::uint32_t lo    = first == 0 ? 0 : read_be32( _fanout + ( first - 1 ) * 4 );
+		std::uint32_t hi    = read_be32( _fanout + first * 4 );
+		while( lo < hi ) {
+			const auto mid = lo + ( hi - lo ) / 2;
+			const int  cmp = std::memcmp( _ids + std::size_t( mid ) * id_size, id.bytes.data(), id_size );
+			if( cmp == 0 ) {
+				return object_offset( mid );
+			}
+			if( cmp < 0 ) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		return {};
+	}
+
+	// ids starting with the given (lower case) hex digits
+	void find_by_prefix( std::string_view hex, std::vector<ObjectId>& out ) const
+	{
+		const int first = hex_value( hex[0] ) * 16 + hex_value( hex[1] );
+		const auto lo   = first == 0 ? 0 : read_be32( _fanout + ( first - 1 ) * 4 );
+		const auto hi   = read_be32( _fanout + first * 4 );
+		for( auto i = lo; i < hi; ++i ) {
+			ObjectId id;
+			std::memcpy( id.bytes.data(), _ids + std::size_t( i ) * id_size, id_size );
+			if( id.to_hex().compare( 0, hex.size(), hex ) == 0 ) {
+				out.push_back( id );
+			}
+		}
+	}
+
+	Object read( std::uint64_t offset ) const
+	{
+		const auto pack = _pack.content();
+		if( offset >= pack.size() ) {
+			fail( "corrupt pack" );
+		}
+
+		// header: type and size (variable length)
+		std::size_t   pos   = offset;
+		unsigned char c     = static_cast<unsigned char>( pack[pos++] );
+		const int     type  = ( c >> 4 ) & 7;
+		std::size_t   size  = c & 0x0f;
+		int           shift = 4;
+		while( c & 0x80 ) {
+			c = static_cast<unsigned char>( pack.at( pos++ ) );
+			size |= std::size_t( c & 0x7f ) << shift;
+			shift += 7;
+		}
+
+		constexpr int ofs_delta = 6;
+		constexpr int ref_delta = 7;
+		if( type == ofs_delta || type == ref_delta ) {
+			std::shared_ptr<const Object> base;
+			if( type == ofs_delta ) {
+				c                      = static_cast<unsigned char>( pack.at( pos++ ) );
+				std::uint64_t distance = c & 0x7f;
+				while( c & 0x80 ) {
+					c        = static_cast<unsigned char>( pack.at( pos++ ) );
+					distance = ( ( distance + 1 ) << 7 ) | ( c & 0x7f );
+				}
+				if( distance > offset ) {
+					fail( "corrupt pack" );
+				}
+				base = read_base( offset - distance );
+			} else {
+				if( pos + id_size > pack.size() ) {
+					fail( "corrupt pack" );
+				}
+				ObjectId base_id;
+				std::memcpy( base_id.bytes.data(), pack.data() + pos, id_size );
+				pos += id_size;
+				base = std::make_shared<const Object>( _repo.read_object( base_id ) );
+			}
+			const auto delta = inflate( pack.substr( pos ), size );
+			return {base->type, apply_delta( base->data, delta )};
+		}
+
+		if( type < 1 || type > 4 ) {
+			fail( "unknown object type in pack" );
+		}
+		return {static_cast<ObjectType>( type ), inflate( pack.substr( pos ), size )};
+	}
+
+private:
+	static const unsigned char* bytes( std::string_view data, std::size_t pos )
+	{
+		return reinterpret_cast<const unsigned char*>( data.data() + pos );
+	}
+
+	std::uint64_t object_offset( std::uint32_t idx ) const
+	{
+		const auto ofs = read_be32( _offsets + std::size_t( idx ) * 4 );
+		if( !( ofs & 0x80000000u ) ) {
+			return ofs;
+		}
+		// offsets >= 2GB are stored in a separate table
+		const auto* p = _offsets64 + std::size_t( ofs & 0x7fffffffu ) * 8;
+		if( p + 8 > _idx_end ) {
+			fail( "corrupt pack index" );
+		}
+		return ( std::uint64_t( read_be32( p ) ) << 32 ) | read_be32( p + 4 );
+	}
+
+	// Delta chains often share their bases, so we keep recently used ones around
+	std::shared_ptr<const Object> read_base( std::uint64_t offset ) const
+	{
+		{
+			std::lock_guard lg( _cache_mx );
+			const auto      it = _base_cache.find( offset );
+			if( it != _base_cache.end() ) {
+				return it->second;
+			}
+		}
+
+		auto base = std::make_shared<const Object>( read( offset ) );
+
+		std::lock_guard lg( _cache_mx );
+		if( _cache_bytes > max_cache_bytes ) {
+			_base_cache.clear();
+			_cache_bytes = 0;
+		}
+		if( _base_cache.emplace( offset, base ).second ) {
+			_cache_bytes += base->data.size();
+		}
+		return base;
+	}
+
+	static constexpr std::size_t max_cache_bytes = 64 * 1024 * 1024;
+
+	const Repository& _repo;
+	MappedFile        _idx;
+	MappedFile        _pack;
+
+	const unsigned char* _fanout    = nullptr;
+	const unsigned char* _ids       = nullptr;
+	const unsigned char* _offsets   = nullptr;
+	const unsigned char* _offsets64 = nullptr;
+	const unsigned char* _idx_end   = nullptr;
+	std::uint32_t        _count     = 0;
+
+	mutable std::mutex                                                       _cache_mx;
+	mutable std::unordered_map<std::uint64_t, std::shared_ptr<const Object>> _base_cache;
+	mutable std::size_t                                                      _cache_bytes = 0;
+};
+
+//################### Repository #####################################
+
+Repository::Repository( const fs::path& git_dir )
+	: _git_dir( git_dir )
+{
+	if( !is_supported() ) {
+		fail( "built without zlib support" );
+	}
+	if( !fs::is_directory( git_dir / "objects" ) ) {
+		fail( git_dir.string() + " is not a git directory" );
+	}
+
+	_object_dirs.push_back( git_dir / "objects" );
+	std::istringstream alternates( read_text_file( git_dir / "objects/info/alternates" ) );
+	for( std::string line; std::getline( alternates, line ); ) {
+		const auto dir = trim( line );
+		if( !dir.empty() && dir[0] != '#' ) {
+			fs::path p( dir );
+			_object_dirs.push_back( p.is_absolute() ? p : git_dir / "objects" / p );
+		}
+	}
+
+	for( const auto& dir : _object_dirs ) {
+		std::error_code ec;
+		for( const auto& entry : fs::directory_iterator( dir / "pack", ec ) ) {
+			if( entry.path().extension() == ".idx" ) {
+				_packs.push_back( std::make_unique<Pack>( *this, entry.path() ) );
+			}
+		}
+	}
+}
+
+Repository::~Repository() = default;
+
+bool Repository::is_supported()
+{
+#ifdef BDG_HAS_ZLIB
+	return true;
+#else
+	return false;
+#endif
+}
+
+std::optional<Object> Repository::read_loose_object( const ObjectId& id ) const
+{
+	const auto hex = id.to_hex();
+	for( const auto& dir : _object_dirs ) {
+		const MappedFile file( dir / hex.substr( 0, 2 ) / hex.substr( 2 ) );
+		if( file.content().empty() ) {
+			continue;
+		}
+
+		// "<type> <size>\0<data>"
+		auto       raw    = inflate( file.content(), std::nullopt );
+		const auto header = raw.find( '\0' );
+		if( header == std::string::npos ) {
+			fail( "corrupt object " + hex );
+		}
+		const auto type = std::string_view( raw ).substr( 0, std::min( raw.find( ' ' ), header ) );
+
+		Object obj;
+		if( type == "commit" ) {
+			obj.type = ObjectType::Commit;
+		} else if( type == "tree" ) {
+			obj.type = ObjectType::Tree;
+		} else if( type == "blob" ) {
+			obj.type = ObjectType::Blob;
+		} else if( type == "tag" ) {
+			obj.type = ObjectType::Tag;
+		} else {
+			fail( "corrupt object " + hex );
+		}
+		obj.data = raw.substr( header + 1 );
+		return obj;
+	}
+	return {};
+}
+
+bool Repository::has_object( const ObjectId& id ) const
+{
+	for( const auto& pack : _packs ) {
+		if( pack->find( id ) ) {
+			return true;
+		}
+	}
+	const auto hex = id.to_hex();
+	for( const auto& dir : _object_dirs ) {
+		if( fs::exists( dir / hex.substr( 0, 2 ) / hex.substr( 2 ) ) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+Object Repository::read_object( const ObjectId& id ) const
+{
+	for( const auto& pack : _packs ) {
+		if( const auto offset = pack->find( id ) ) {
+			return pack->read( *offset );
+		}
+	}
+	if( auto obj = read_loose_object( id ) ) {
+		return std::move( *obj );
+	}
+	fail( "object " + id.to_hex() + " not found in " + _git_dir.string() );
+}
+
+std::optional<ObjectId> Repository::read_ref( const std::string& ref, int depth ) const
+{
+	if( depth > 5 ) {
+		return {}; // symbolic ref loop
+	}
+
+	const auto file = _git_dir / ref;
+	if( fs::is_regular_file( file ) ) {
+		const auto content = read_text_file( file );
+		const auto value   = trim( content );
+		if( value.substr( 0, 5 ) == "ref: " ) {
+			return read_ref( std::string( trim( value.substr( 5 ) ) ), depth + 1 );
+		}
+		return ObjectId::from_hex( value );
+	}
+
+	// "<id> <ref>" lines, peeled tags ("^<id>") and comments are ignored
+	std::istringstream packed_refs( read_text_file( _git_dir / "packed-refs" ) );
+	for( std::string line; std::getline( packed_refs, line ); ) {
+		const std::string_view l = trim( line );
+		if( l.size() > 2 * id_size + 1 && l.substr( 2 * id_size + 1 ) == ref ) {
+			return ObjectId::from_hex( l.substr( 0, 2 * id_size ) );
+		}
+	}
+	return {};
+}
+
+std::optional<ObjectId> Repository::find_by_prefix( std::string_view hex ) const
+{
+	if( hex.size() < 4 || hex.size() > 2 * id_size
+		|| !std::all_of( hex.begin(), hex.end(), []( char c ) { return hex_value( c ) >= 0; } ) ) {
+		return {};
+	}
+	std::string prefix( hex );
+	std::transform( prefix.begin(), prefix.end(), prefix.begin(), []( char c ) { return std::tolower( c ); } );
+
+	std::vector<ObjectId> matches;
+	for( const auto& pack : _packs ) {
+		pack->find_by_prefix( prefix, matches );
+	}
+	for( const auto& dir : _object_dirs ) {
+		std::error_code ec;
+		for( const auto& entry : fs::directory_iterator( dir / prefix.substr( 0, 2 ), ec ) ) {
+			const auto id = ObjectId::from_hex( prefix.substr( 0, 2 ) + entry.path().filename().string() );
+			if( id && id->to_hex().compare( 0, prefix.size(), prefix ) == 0 ) {
+				matches.push_back( *id );
+			}
+		}
+	}
+
+	std::sort( matches.begin(), matches.end() );
+	matches.erase( std::unique( matches.begin(), matches.end() ), matches.end() );
+	if( matches.size() > 1 ) {
+		fail( "ambiguous object id " + prefix );
+	}
+	if( matches.empty() ) {
+		return {};
+	}
+	return matches.front();
+}
+
+ObjectId Repository::resolve( std::string_view revision ) const
+{
+	auto id = ObjectId::from_hex( revision );
+
+	const std::string rev( revision );
+	for( const auto& ref : {rev, "refs/" + rev, "refs/tags/" + rev, "refs/heads/" + rev, "refs/remotes/" + rev} ) {
+		if( !id ) {
+			id = read_ref( ref );
+		}
+	}
+	if( !id ) {
+		id = find_by_prefix( revision );
+	}
+	if( !id ) {
+		fail( "unknown revision '" + rev + "' in " + _git_dir.string() );
+	}
+	return *id;
+}
+
+ObjectId Repository::get_tree( const ObjectId& commit_or_tree ) const
+{
+	auto id  = commit_or_tree;
+	auto obj = read_object( id );
+	while( obj.type == ObjectType::Tag ) {
+		const auto target = ObjectId::from_hex( std::string_view( obj.data ).substr( 7, 2 * id_size ) );
+		if( !target ) {
+			fail( "corrupt tag " + id.to_hex() );
+		}
+		id  = *target;
+		obj = read_object( id );
+	}
+	if( obj.type == ObjectType::Tree ) {
+		return id;
+	}
+	if( obj.type != ObjectType::Commit || obj.data.substr( 0, 5 ) != "tree " ) {
+		fail( id.to_hex() + " is neither a commit nor a tree" );
+	}
+	const auto tree = ObjectId::from_hex( std::string_view( obj.data ).substr( 5, 2 * id_size ) );
+	if( !tree ) {
+		fail( "corrupt commit " + id.to_hex() );
+	}
+	return *tree;
+}
+
+std::vector<TreeEntry> Repository::read_tree( const ObjectId& tree ) const
+{
+	const auto obj = read_object( tree );
+	if( obj.type != ObjectType::Tree ) {
+		fail( tree.to_hex() + " is not a tree" );
+	}
+
+	// entries are "<octal mode> <name>\0<20 byte id>"
+	std::vector<TreeEntry> entries;
+	std::string_view       data = obj.data;
+	while( !data.empty() ) {
+		const auto space = data.find( ' ' );
+		const auto nul   = data.find( '\0' );
+		if( space == std::string_view::npos || nul == std::string_view::npos || space > nul
+			|| nul + 1 + id_size > data.size() ) {
+			fail( "corrupt tree " + tree.to_hex() );
+		}
+
+		TreeEntry entry;
+		for( char c : data.substr( 0, space ) ) {
+			entry.mode = entry.mode * 8 + static_cast<std::uint32_t>( c - '0' );
+		}
+		entry.name = std::string( data.substr( space + 1, nul - space - 1 ) );
+		std::memcpy( entry.id.bytes.data(), data.data() + nul + 1, id_size );
+		entries.push_back( std::move( entry ) );
+
+		data.remove_prefix( nul + 1 + id_size );
+	}
+	return entries;
+}
+
+std::optional<fs::path> find_git_dir( const fs::path& worktree )
+{
+	const auto dot_git = worktree / ".git";
+	if( fs::is_directory( dot_git ) ) {
+		return dot_git;
+	}
+	if( fs::is_regular_file( dot_git ) ) {
+		// submodules and worktrees have a .git file containing "gitdir: <path>"
+		const auto content = read_text_file( dot_git );
+		const auto value   = trim( content );
+		if( value.substr( 0, 8 ) == "gitdir: " ) {
+			fs::path dir( trim( value.substr( 8 ) ) );
+			return dir.is_absolute() ? dir : ( worktree / dir ).lexically_normal();
+		}
+	}
+	return {};
+}
+
+} // namespace mdev::git
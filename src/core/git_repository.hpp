@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mdev::git {
+
+struct ObjectId {
+	std::array<unsigned char, 20> bytes{};
+
+	static std::optional<ObjectId> from_hex( std::string_view hex );
+	std::string                    to_hex() const;
+
+	friend bool operator==( const ObjectId& l, const ObjectId& r ) { return l.bytes == r.bytes; }
+	friend bool operator!=( const ObjectId& l, const ObjectId& r ) { return l.bytes != r.bytes; }
+	friend bool operator<( const ObjectId& l, const ObjectId& r ) { return l.bytes < r.bytes; }
+};
+
+enum class ObjectType { None = 0, Commit = 1, Tree = 2, Blob = 3, Tag = 4 };
+
+struct Object {
+	ObjectType  type = ObjectType::None;
+	std::string data;
+};
+
+struct TreeEntry {
+	std::string   name;
+	std::uint32_t mode = 0;
+	ObjectId      id;
+
+	bool is_tree() const { return mode == 040000; }
+	bool is_gitlink() const { return mode == 0160000; } // a submodule - id is a commit in the submodule's repository
+	bool is_file() const { return ( mode & 0170000 ) == 0100000; }
+};
+
+/**
+ * Read-only access to the object store of a git repository (loose objects and packfiles with .idx version 2).
+ *
+ * All functions throw std::runtime_error if an object is missing or corrupt.
+ * Reading objects is thread safe.
+ */
+class Repository {
+public:
+	// git_dir is the .git directory itself (e.g. <worktree>/.git or <superproject>/.git/modules/<name>)
+	explicit Repository( const std::filesystem::path& git_dir );
+	Repository( const Repository& ) = delete;
+	Repository& operator=( const Repository& ) = delete;
+	~Repository();
+
+	// false if this was built without zlib support, in which case the constructor always throws
+	static bool is_supported();
+
+	const std::filesystem::path& git_dir() const { return _git_dir; }
+
+	// Accepts a (possibly abbreviated) object id, HEAD, branch names, tag names and full ref names
+	ObjectId resolve( std::string_view revision ) const;
+
+	bool   has_object( const ObjectId& id ) const;
+	Object read_object( const ObjectId& id ) const;
+
+	// commit_or_tree may also be an annotated tag
+	ObjectId               get_tree( const ObjectId& commit_or_tree ) const;
+	std::vector<TreeEntry> read_tree( const ObjectId& tree ) const;
+
+private:
+	class Pack;
+
+	std::optional<Object>   read_loose_object( const ObjectId& id ) const;
+	std::optional<ObjectId> read_ref( const std::string& ref, int depth = 0 ) const;
+	std::optional<ObjectId> find_by_prefix( std::string_view hex ) const;
+
+	std::filesystem::path              _git_dir;
+	std::vector<std::filesystem::path> _object_dirs; // own objects directory + alternates
+	std::vector<std::unique_ptr<Pack>> _packs;
+};
+
+// Returns the git directory of a worktree (<worktree>/.git or where a .git file points to)
+std::optional<std::filesystem::path> find_git_dir( const std::filesystem::path& worktree );
+
+} // namespace mdev::git
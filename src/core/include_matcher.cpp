@@ -0,0 +1,54 @@
+#include "include_matcher.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace mdev::boostdep {
+
+IncludeMatcher::IncludeMatcher( const std::vector<String_t>& roots )
+	: _roots( roots )
+{
+	if( _roots.empty() ) {
+		throw std::invalid_argument( "IncludeMatcher needs at least one include root" );
+	}
+
+	for( const auto& root : _roots ) {
+		for( const char c : root ) {
+			auto& column = _column_of[static_cast<unsigned char>( c )];
+			if( column == 0 ) {
+				if( _columns > std::numeric_limits<std::uint8_t>::max() ) {
+					throw std::invalid_argument( "Too many distinct characters in the include roots" );
+				}
+				column = static_cast<std::uint8_t>( _columns++ );
+			}
+		}
+	}
+
+	_transitions.assign( _columns, 0 );
+	_accepting.assign( 1, 0 );
+	_min_root_size = _roots.front().size();
+
+	for( const auto& root : _roots ) {
+		_min_root_size     = std::min( _min_root_size, root.size() );
+		std::uint32_t node = 0;
+		for( const char c : root ) {
+			auto& next = _transitions[node * _columns + _column_of[static_cast<unsigned char>( c )]];
+			if( next == 0 ) {
+				next = static_cast<std::uint32_t>( _accepting.size() );
+				_accepting.push_back( 0 );
+				_transitions.resize( _transitions.size() + _columns, 0 ); // invalidates next
+			}
+			node = _transitions[node * _columns + _column_of[static_cast<unsigned char>( c )]];
+		}
+		_accepting[node] = 1;
+	}
+}
+
+const IncludeMatcher& IncludeMatcher::boost()
+{
+	static const IncludeMatcher matcher( {"boost/"} );
+	return matcher;
+}
+
+} // namespace mdev::boostdep
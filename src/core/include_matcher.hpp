@@ -0,0 +1,62 @@
+#pragma once
+
+#include "utils.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace mdev::boostdep {
+
+/**
+ * Decides whether an included path belongs to one of a set of include roots (e.g. "boost/", "mycorp/").
+ *
+ * The roots are compiled into a prefix trie with a dense transition table (bytes that don't appear in any root share
+ * one column), so a lookup only touches one table row per character - no matter how many roots there are.
+ * Roots are matched literally, so they should usually end with a '/'.
+ */
+class IncludeMatcher {
+public:
+	explicit IncludeMatcher( const std::vector<String_t>& roots );
+
+	// Only matches "boost/" (what the scanner always did)
+	static const IncludeMatcher& boost();
+
+	// true if path starts with one of the roots
+	bool matches( std::string_view path ) const
+	{
+		std::uint32_t node = 0;
+		for( std::size_t i = 0; !_accepting[node]; ++i ) {
+			if( i == path.size() ) {
+				return false;
+			}
+			node = _transitions[node * _columns + _column_of[static_cast<unsigned char>( path[i] )]];
+			if( node == 0 ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The shortest include that can match: <root/a.hpp>
+	std::size_t min_include_size() const { return _min_root_size + 7; }
+	// The shortest line with such an include: #include <root/a.h>
+	std::size_t min_line_size() const { return _min_root_size + 14; }
+
+	const std::vector<String_t>& roots() const { return _roots; }
+
+private:
+	std::vector<String_t> _roots;
+	std::size_t           _min_root_size = 0;
+
+	std::array<std::uint8_t, 256> _column_of{}; // 0 for all bytes that don't appear in any root
+	std::size_t                   _columns = 1;
+	// node * _columns + column -> next node. The start node 0 is never the target of a transition,
+	// so 0 means "no root continues with this byte"
+	std::vector<std::uint32_t> _transitions;
+	std::vector<std::uint8_t>  _accepting;
+};
+
+} // namespace mdev::boostdep
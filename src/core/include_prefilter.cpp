@@ -0,0 +1,317 @@
+#include "include_prefilter.hpp"
+
+#include <cstring>
+
+// clang-format off
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __SSE2__ ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define BDG_HAS_SSE2
+	#include <immintrin.h>
+
+	#if defined( __GNUC__ ) || defined( __clang__ )
+		#define BDG_HAS_AVX2
+		#define BDG_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+	#elif defined( _MSC_VER )
+		#include <intrin.h>
+		#define BDG_HAS_AVX2
+		#define BDG_TARGET_AVX2
+	#endif
+#endif
+// clang-format on
+
+namespace mdev::boostdep {
+
+namespace {
+
+constexpr std::string_view include_keyword = "include";
+
+bool is_blank( char c )
+{
+	return c == ' ' || c == '\t';
+}
+
+bool starts_with( const char* p, const char* end, std::string_view prefix )
+{
+	return static_cast<std::size_t>( end - p ) >= prefix.size() && std::string_view( p, prefix.size() ) == prefix;
+}
+
+/*
+ * hash points to a '#' in [begin,end).
+ * If it starts a line of the form `#include <root` (for one of the roots of matcher) the whole line gets added to
+ * the candidates
+ * Returns the position from which the search for the next '#' should continue (always > hash)
+ */
+const char* check_candidate( const char*                    begin,
+							 const char*                    end,
+							 const char*                    hash,
+							 const IncludeMatcher&          matcher,
+							 std::vector<std::string_view>& candidates )
+{
+	// '#' has to be the first non-blank character in the line
+	const char* line_start = hash;
+	while( line_start != begin && is_blank( line_start[-1] ) ) {
+		--line_start;
+	}
+	if( line_start != begin && line_start[-1] != '\n' ) {
+		return hash + 1;
+	}
+
+	const char* p = hash + 1;
+	while( p != end && is_blank( *p ) ) {
+		++p;
+	}
+	if( !starts_with( p, end, include_keyword ) ) {
+		return p;
+	}
+	p += include_keyword.size();
+	while( p != end && is_blank( *p ) ) {
+		++p;
+	}
+	if( p == end || ( *p != '<' && *p != '"' ) || !matcher.matches( std::string_view( p + 1, end - p - 1 ) ) ) {
+		return p;
+	}
+
+	auto line_end = static_cast<const char*>( std::memchr( p, '\n', end - p ) );
+	if( line_end == nullptr ) {
+		line_end = end;
+	}
+	candidates.emplace_back( line_start, line_end - line_start );
+	return line_end;
+}
+
+void find_include_candidates_none( std::string_view content, std::vector<std::string_view>& candidates )
+{
+	std::size_t pos = 0;
+	while( pos < content.size() ) {
+		auto end = content.find( '\n', pos );
+		if( end == std::string_view::npos ) {
+			end = content.size();
+		}
+		candidates.push_back( content.substr( pos, end - pos ) );
+		pos = end + 1;
+	}
+}
+
+// continues the search from pos (which has to be in [begin,end])
+void find_include_candidates_scalar( const char*                    begin,
+									 const char*                    pos,
+									 const char*                    end,
+									 const IncludeMatcher&          matcher,
+									 std::vector<std::string_view>& candidates )
+{
+	while( pos != end ) {
+		auto hash = static_cast<const char*>( std::memchr( pos, '#', end - pos ) );
+		if( hash == nullptr ) {
+			return;
+		}
+		pos = check_candidate( begin, end, hash, matcher, candidates );
+	}
+}
+
+#ifdef BDG_HAS_SSE2
+
+unsigned count_trailing_zeros( unsigned mask )
+{
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward( &idx, mask );
+	return static_cast<unsigned>( idx );
+#else
+	return static_cast<unsigned>( __builtin_ctz( mask ) );
+#endif
+}
+
+/*
+ * Processes a block of (up to 32) bytes starting at block, whose '#' positions are marked in mask.
+ * Returns the position where the next block should start
+ */
+const char* process_block( const char*                    begin,
+						   const char*                    end,
+						   const char*                    block,
+						   const char*                    block_end,
+						   unsigned                       mask,
+						   const IncludeMatcher&          matcher,
+						   std::vector<std::string_view>& candidates )
+{
+	while( mask != 0 ) {
+		const char* next = check_candidate( begin, end, block + count_trailing_zeros( mask ), matcher, candidates );
+		if( next >= block_end ) {
+			return next;
+		}
+		// ignore all '#' we skipped over
+		mask &= ~0u << ( next - block );
+	}
+	return block_end;
+}
+
+/*
+ * The vectorized kernels don't only look for '#', but for '#' that is followed by "in" or a blank.
+ * This filters out the vast majority of preprocessor directives (#if, #define, #endif ...) without
+ * ever leaving the simd registers.
+ * They need to read 2 bytes past the end of each block, so blocks are only processed up to end-2.
+ */
+void find_include_candidates_sse2( std::string_view               content,
+								   const IncludeMatcher&          matcher,
+								   std::vector<std::string_view>& candidates )
+{
+	const char* const begin = content.data();
+	const char* const end   = begin + content.size();
+
+	const __m128i hash  = _mm_set1_epi8( '#' );
+	const __m128i i     = _mm_set1_epi8( 'i' );
+	const __m128i n     = _mm_set1_epi8( 'n' );
+	const __m128i space = _mm_set1_epi8( ' ' );
+	const __m128i tab   = _mm_set1_epi8( '\t' );
+
+	const char* p = begin;
+	while( end - p >= 16 + 2 ) {
+		const __m128i c0 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+		const __m128i c1 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p + 1 ) );
+		const __m128i c2 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p + 2 ) );
+
+		const __m128i in    = _mm_and_si128( _mm_cmpeq_epi8( c1, i ), _mm_cmpeq_epi8( c2, n ) );
+		const __m128i blank = _mm_or_si128( _mm_cmpeq_epi8( c1, space ), _mm_cmpeq_epi8( c1, tab ) );
+		const __m128i hits  = _mm_and_si128( _mm_cmpeq_epi8( c0, hash ), _mm_or_si128( in, blank ) );
+
+		const auto mask = static_cast<unsigned>( _mm_movemask_epi8( hits ) );
+
+		p = mask == 0 ? p + 16 : process_block( begin, end, p, p + 16, mask, matcher, candidates );
+	}
+	find_include_candidates_scalar( begin, p, end, matcher, candidates );
+}
+
+#ifdef BDG_HAS_AVX2
+
+BDG_TARGET_AVX2 void find_include_candidates_avx2( std::string_view               content,
+												   const IncludeMatcher&          matcher,
+												   std::vector<std::string_view>& candidates )
+{
+	const char* const begin = content.data();
+	const char* const end   = begin + content.size();
+
+	const __m256i hash  = _mm256_set1_epi8( '#' );
+	const __m256i i     = _mm256_set1_epi8( 'i' );
+	const __m256i n     = _mm256_set1_epi8( 'n' );
+	const __m256i space = _mm256_set1_epi8( ' ' );
+	const __m256i tab   = _mm256_set1_epi8( '\t' );
+
+	const char* p = begin;
+	while( end - p >= 32 + 2 ) {
+		const __m256i c0     = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+		const __m256i hashes = _mm256_cmpeq_epi8( c0, hash );
+		// most blocks don't contain any '#' at all
+		if( _mm256_testz_si256( hashes, hashes ) ) {
+			p += 32;
+			continue;
+		}
+
+		const __m256i c1 = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p + 1 ) );
+		const __m256i c2 = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p + 2 ) );
+
+		const __m256i in    = _mm256_and_si256( _mm256_cmpeq_epi8( c1, i ), _mm256_cmpeq_epi8( c2, n ) );
+		const __m256i blank = _mm256_or_si256( _mm256_cmpeq_epi8( c1, space ), _mm256_cmpeq_epi8( c1, tab ) );
+		const __m256i hits  = _mm256_and_si256( hashes, _mm256_or_si256( in, blank ) );
+
+		const auto mask = static_cast<unsigned>( _mm256_movemask_epi8( hits ) );
+
+		p = mask == 0 ? p + 32 : process_block( begin, end, p, p + 32, mask, matcher, candidates );
+	}
+	find_include_candidates_scalar( begin, p, end, matcher, candidates );
+}
+
+bool cpu_has_avx2()
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+	__builtin_cpu_init();
+	return __builtin_cpu_supports( "avx2" );
+#else
+	int info[4]{};
+	__cpuid( info, 0 );
+	if( info[0] < 7 ) {
+		return false;
+	}
+	__cpuid( info, 1 );
+	const bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+	const bool avx     = ( info[2] & ( 1 << 28 ) ) != 0;
+	// the os also has to save the ymm registers on context switches
+	if( !osxsave || !avx || ( _xgetbv( 0 ) & 0x6 ) != 0x6 ) {
+		return false;
+	}
+	__cpuidex( info, 7, 0 );
+	return ( info[1] & ( 1 << 5 ) ) != 0;
+#endif
+}
+
+#endif // BDG_HAS_AVX2
+#endif // BDG_HAS_SSE2
+
+} // namespace
+
+bool is_supported( PrefilterKernel kernel )
+{
+	switch( kernel ) {
+		case PrefilterKernel::Auto:
+		case PrefilterKernel::None:
+		case PrefilterKernel::Scalar: return true;
+#ifdef BDG_HAS_SSE2
+		case PrefilterKernel::SSE2: return true;
+#endif
+#ifdef BDG_HAS_AVX2
+		case PrefilterKernel::AVX2: {
+			static const bool has_avx2 = cpu_has_avx2();
+			return has_avx2;
+		}
+#endif
+		default: return false;
+	}
+}
+
+PrefilterKernel best_prefilter_kernel()
+{
+	static const PrefilterKernel best = [] {
+		for( auto k : {PrefilterKernel::AVX2, PrefilterKernel::SSE2} ) {
+			if( is_supported( k ) ) {
+				return k;
+			}
+		}
+		return PrefilterKernel::Scalar;
+	}();
+	return best;
+}
+
+const char* to_string( PrefilterKernel kernel )
+{
+	switch( kernel ) {
+		case PrefilterKernel::Auto: return "auto";
+		case PrefilterKernel::None: return "none";
+		case PrefilterKernel::Scalar: return "scalar";
+		case PrefilterKernel::SSE2: return "sse2";
+		case PrefilterKernel::AVX2: return "avx2";
+	}
+	return "unknown";
+}
+
+void find_include_candidates( std::string_view               content,
+							  std::vector<std::string_view>& candidates,
+							  PrefilterKernel                kernel,
+							  const IncludeMatcher&          matcher )
+{
+	if( kernel == PrefilterKernel::Auto || !is_supported( kernel ) ) {
+		kernel = best_prefilter_kernel();
+	}
+
+	switch( kernel ) {
+#ifdef BDG_HAS_AVX2
+		case PrefilterKernel::AVX2: find_include_candidates_avx2( content, matcher, candidates ); return;
+#endif
+#ifdef BDG_HAS_SSE2
+		case PrefilterKernel::SSE2: find_include_candidates_sse2( content, matcher, candidates ); return;
+#endif
+		case PrefilterKernel::None: find_include_candidates_none( content, candidates ); return;
+		default:
+			find_include_candidates_scalar(
+				content.data(), content.data(), content.data() + content.size(), matcher, candidates );
+			return;
+	}
+}
+
+} // namespace mdev::boostdep
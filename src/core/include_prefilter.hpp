@@ -0,0 +1,32 @@
+#pragma once
+
+#include "include_matcher.hpp"
+
+#include <string_view>
+#include <vector>
+
+namespace mdev::boostdep {
+
+// None:   No prefiltering at all - every line is a candidate (that is what the scanner did originally)
+// Scalar: memchr based search for '#'
+// SSE2 / AVX2: vectorized search for '#'
+// Auto:   Best kernel supported by the cpu we are running on
+enum class PrefilterKernel { Auto, None, Scalar, SSE2, AVX2 };
+
+bool            is_supported( PrefilterKernel kernel );
+PrefilterKernel best_prefilter_kernel();
+const char*     to_string( PrefilterKernel kernel );
+
+/**
+ * Appends all lines from content to candidates, that look like `#include <root...` or `#include "root...` for one of
+ * the roots of matcher (with arbitrary spaces and tabs in between). Lines are split at '\n' just like std::getline does.
+ *
+ * Every line that might be such an include is guaranteed to be part of the result,
+ * but the lines still have to be parsed properly (e.g. the closing bracket isn't checked).
+ */
+void find_include_candidates( std::string_view               content,
+							  std::vector<std::string_view>& candidates,
+							  PrefilterKernel                kernel  = PrefilterKernel::Auto,
+							  const IncludeMatcher&          matcher = IncludeMatcher::boost() );
+
+} // namespace mdev::boostdep
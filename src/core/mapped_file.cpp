@@ -0,0 +1,133 @@
+#include "mapped_file.hpp"
+
+#include <utility>
+
+// clang-format off
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+// clang-format on
+
+namespace mdev {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile( const std::filesystem::path& file )
+{
+	HANDLE fh = ::CreateFileW( file.c_str(),
+							   GENERIC_READ,
+							   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+							   nullptr,
+							   OPEN_EXISTING,
+							   FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+							   nullptr );
+	if( fh == INVALID_HANDLE_VALUE ) {
+		return;
+	}
+
+	LARGE_INTEGER size{};
+	if( !::GetFileSizeEx( fh, &size ) || size.QuadPart == 0 ) {
+		::CloseHandle( fh );
+		return;
+	}
+
+	HANDLE mh = ::CreateFileMappingW( fh, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	::CloseHandle( fh );
+	if( mh == nullptr ) {
+		return;
+	}
+
+	// the view keeps the mapping object alive
+	auto* ptr = ::MapViewOfFile( mh, FILE_MAP_READ, 0, 0, 0 );
+	::CloseHandle( mh );
+	if( ptr == nullptr ) {
+		return;
+	}
+
+	_data = static_cast<const char*>( ptr );
+	_size = static_cast<std::size_t>( size.QuadPart );
+}
+
+void MappedFile::reset() noexcept
+{
+	if( _data ) {
+		::UnmapViewOfFile( _data );
+	}
+	_data = nullptr;
+	_size = 0;
+}
+
+#else
+
+MappedFile::MappedFile( const std::filesystem::path& file )
+{
+	const int fd = ::open( file.c_str(), O_RDONLY | O_CLOEXEC );
+	if( fd < 0 ) {
+		return;
+	}
+
+	struct stat st {
+	};
+	// mmap doesn't accept a length of 0
+	if( ::fstat( fd, &st ) != 0 || st.st_size <= 0 ) {
+		::close( fd );
+		return;
+	}
+
+	void* ptr = ::mmap( nullptr, static_cast<std::size_t>( st.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+	::close( fd ); // the mapping stays valid after closing the descriptor
+	if( ptr == MAP_FAILED ) {
+		return;
+	}
+#ifdef MADV_SEQUENTIAL
+	::madvise( ptr, static_cast<std::size_t>( st.st_size ), MADV_SEQUENTIAL );
+#endif
+
+	_data = static_cast<const char*>( ptr );
+	_size = static_cast<std::size_t>( st.st_size );
+}
+
+void MappedFile::reset() noexcept
+{
+	if( _data ) {
+		::munmap( const_cast<char*>( _data ), _size );
+	}
+	_data = nullptr;
+	_size = 0;
+}
+
+#endif
+
+MappedFile::MappedFile( MappedFile&& other ) noexcept
+	: _data( std::exchange( other._data, nullptr ) )
+	, _size( std::exchange( other._size, 0 ) )
+{
+}
+
+MappedFile& MappedFile::operator=( MappedFile&& other ) noexcept
+{
+	if( this != &other ) {
+		reset();
+		_data = std::exchange( other._data, nullptr );
+		_size = std::exchange( other._size, 0 );
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	reset();
+}
+
+} // namespace mdev
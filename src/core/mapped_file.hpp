@@ -0,0 +1,32 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+namespace mdev {
+
+// Read-only memory mapping of a whole file.
+// Empty files and files that can't be opened result in an empty content()
+class MappedFile {
+public:
+	MappedFile() = default;
+	explicit MappedFile( const std::filesystem::path& file );
+
+	MappedFile( MappedFile&& other ) noexcept;
+	MappedFile& operator=( MappedFile&& other ) noexcept;
+
+	MappedFile( const MappedFile& ) = delete;
+	MappedFile& operator=( const MappedFile& ) = delete;
+
+	~MappedFile();
+
+	std::string_view content() const { return {_data, _size}; }
+
+private:
+	void reset() noexcept;
+
+	const char* _data = nullptr;
+	std::size_t _size = 0;
+};
+
+} // namespace mdev
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "bitset.hpp"
+#include "boostdep.hpp"
+#include "dependency_graph.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace mdev::boostdep {
+
+// Dense module numbers, in the order of the module names (so iterating over them yields sorted names)
+struct ModuleNumbers {
+	std::vector<std::uint32_t>    of_file; // module number of every file
+	std::vector<std::string_view> names;   // module number -> name
+};
+
+/**
+ * Module dependency map over module numbers: one bitset of dependencies per module.
+ * Worker threads each fill their own ModuleSets, which are OR-ed together at the end
+ */
+class ModuleSets {
+public:
+	ModuleSets() = default;
+	explicit ModuleSets( std::size_t module_cnt )
+		: _deps( module_cnt )
+	{
+	}
+
+	std::size_t module_count() const { return _deps.size(); }
+
+	// module becomes part of the result, even if it doesn't depend on anything
+	DynamicBitset& add_module( std::uint32_t module )
+	{
+		auto& deps = _deps[module];
+		if( deps.size() == 0 ) {
+			deps = DynamicBitset( _deps.size() );
+		}
+		return deps;
+	}
+
+	void merge( const ModuleSets& other )
+	{
+		for( std::size_t m = 0; m < _deps.size(); ++m ) {
+			if( other._deps[m].size() != 0 ) {
+				add_module( static_cast<std::uint32_t>( m ) ).merge( other._deps[m] );
+			}
+		}
+	}
+
+	// API format, without self dependencies. Only the modules that are part of the result become nodes
+	DependencyGraph to_dependency_graph( const std::vector<std::string_view>& names ) const
+	{
+		std::vector<DependencyGraph::NodeId> node_of( _deps.size(), DependencyGraph::npos );
+		std::vector<std::string_view>        node_names;
+		for( std::size_t m = 0; m < _deps.size(); ++m ) {
+			if( _deps[m].size() != 0 ) {
+				node_of[m] = static_cast<DependencyGraph::NodeId>( node_names.size() );
+				node_names.push_back( names[m] );
+			}
+		}
+
+		std::vector<std::uint32_t>           offsets{0};
+		std::vector<DependencyGraph::NodeId> deps;
+		for( std::size_t m = 0; m < _deps.size(); ++m ) {
+			if( _deps[m].size() == 0 ) {
+				continue;
+			}
+			_deps[m].for_each( [&]( std::size_t dep ) {
+				if( dep != m && node_of[dep] != DependencyGraph::npos ) {
+					deps.push_back( node_of[dep] );
+				}
+			} );
+			offsets.push_back( static_cast<std::uint32_t>( deps.size() ) );
+		}
+		return DependencyGraph( node_names, offsets, deps );
+	}
+
+private:
+	std::vector<DynamicBitset> _deps; // size 0: module is not part of the result
+};
+
+} // namespace mdev::boostdep
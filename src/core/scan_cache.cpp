@@ -0,0 +1,268 @@
+#include "scan_cache.hpp"
+
+#include "mapped_file.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <system_error>
+
+// clang-format off
+#ifndef _WIN32
+	#include <sys/stat.h>
+#endif
+// clang-format on
+
+namespace fs = std::filesystem;
+
+namespace mdev::boostdep {
+
+namespace {
+
+// Bump this whenever the file format or the way included files are detected changes
+constexpr std::uint32_t cache_format_version = 1;
+constexpr char          cache_magic[8]       = {'B', 'D', 'G', 'S', 'C', 'A', 'N', '\0'};
+
+// stable across platforms and runs (unlike std::hash)
+std::uint64_t fnv1a( std::string_view str )
+{
+	std::uint64_t hash = 14695981039346656037ull;
+	for( unsigned char c : str ) {
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+template<class T>
+void write_pod( std::ostream& os, const T& value )
+{
+	os.write( reinterpret_cast<const char*>( &value ), sizeof( value ) );
+}
+
+void write_string( std::ostream& os, std::string_view str )
+{
+	write_pod( os, static_cast<std::uint32_t>( str.size() ) );
+	os.write( str.data(), str.size() );
+}
+
+// Bounds checked sequential reading from a memory buffer
+struct Reader {
+	std::string_view data;
+	bool             ok = true;
+
+	template<class T>
+	T read_pod()
+	{
+		T value{};
+		if( data.size() < sizeof( T ) ) {
+			ok = false;
+			return value;
+		}
+		std::memcpy( &value, data.data(), sizeof( T ) );
+		data.remove_prefix( sizeof( T ) );
+		return value;
+	}
+
+	std::string_view read_string()
+	{
+		const auto size = read_pod<std::uint32_t>();
+		if( !ok || data.size() < size ) {
+			ok = false;
+			return {};
+		}
+		auto str = data.substr( 0, size );
+		data.remove_prefix( size );
+		return str;
+	}
+};
+
+} // namespace
+
+std::optional<FileStamp> get_file_stamp( const fs::path& file )
+{
+#ifdef _WIN32
+	std::error_code ec;
+	const auto      size  = fs::file_size( file, ec );
+	const auto      mtime = fs::last_write_time( file, ec );
+	if( ec ) {
+		return {};
+	}
+	return FileStamp{size, static_cast<std::int64_t>( mtime.time_since_epoch().count() ), 0};
+#else
+	struct stat st {
+	};
+	if( ::stat( file.c_str(), &st ) != 0 ) {
+		return {};
+	}
+#ifdef __APPLE__
+	const auto& ts = st.st_mtimespec;
+#else
+	const auto& ts = st.st_mtim;
+#endif
+	return FileStamp{static_cast<std::uint64_t>( st.st_size ),
+					 static_cast<std::int64_t>( ts.tv_sec ) * 1'000'000'000 + ts.tv_nsec,
+					 static_cast<std::uint64_t>( st.st_ino )};
+#endif
+}
+
+bool ScanCache::load( const fs::path& file )
+{
+	clear();
+
+	const MappedFile mapping( file );
+	Reader           reader{mapping.content()};
+
+	const auto magic = reader.data.substr( 0, sizeof( cache_magic ) );
+	if( magic != std::string_view( cache_magic, sizeof( cache_magic ) ) ) {
+		return false;
+	}
+	reader.data.remove_prefix( sizeof( cache_magic ) );
+	if( reader.read_pod<std::uint32_t>() != cache_format_version ) {
+		return false;
+	}
+
+	const auto entry_cnt = reader.read_pod<std::uint64_t>();
+	for( std::uint64_t i = 0; i < entry_cnt && reader.ok; ++i ) {
+		const auto path  = reader.read_string();
+		auto&      entry = _entries[String_t( path )];
+
+		entry.stamp.size  = reader.read_pod<std::uint64_t>();
+		entry.stamp.mtime = reader.read_pod<std::int64_t>();
+		entry.stamp.inode = reader.read_pod<std::uint64_t>();
+
+		const auto include_cnt = reader.read_pod<std::uint32_t>();
+		for( std::uint32_t k = 0; k < include_cnt && reader.ok; ++k ) {
+			entry.included_files.emplace_back( reader.read_string() );
+		}
+	}
+
+	if( !reader.ok ) {
+		clear(); // truncated or otherwise corrupted file
+		return false;
+	}
+	return true;
+}
+
+bool ScanCache::save( const fs::path& file ) const
+{
+	std::error_code ec;
+	fs::create_directories( file.parent_path(), ec );
+
+	// write to a temporary file first, so we never leave a half written cache behind
+	auto tmp_file = file;
+	tmp_file += ".tmp";
+	{
+		std::ofstream os( tmp_file, std::ios::binary | std::ios::trunc );
+		if( !os ) {
+			return false;
+		}
+
+		std::shared_lock lock( _mx );
+
+		std::uint64_t entry_cnt = 0;
+		for( const auto& [path, entry] : _entries ) {
+			entry_cnt += entry.generation == _generation;
+		}
+
+		os.write( cache_magic, sizeof( cache_magic ) );
+		write_pod( os, cache_format_version );
+		write_pod( os, entry_cnt );
+		for( const auto& [path, entry] : _entries ) {
+			if( entry.generation != _generation ) {
+				continue;
+			}
+			write_string( os, path );
+			write_pod( os, entry.stamp.size );
+			write_pod( os, entry.stamp.mtime );
+			write_pod( os, entry.stamp.inode );
+			write_pod( os, static_cast<std::uint32_t>( entry.included_files.size() ) );
+			for( const auto& inc : entry.included_files ) {
+				write_string( os, inc );
+			}
+		}
+		if( !os ) {
+			return false;
+		}
+	}
+
+	fs::rename( tmp_file, file, ec );
+	return !ec;
+}
+
+void ScanCache::clear()
+{
+	std::unique_lock lock( _mx );
+	_entries.clear();
+	_hits   = 0;
+	_misses = 0;
+}
+
+void ScanCache::start_scan()
+{
+	std::unique_lock lock( _mx );
+	_generation++;
+	_hits   = 0;
+	_misses = 0;
+}
+
+std::optional<std::vector<String_t>> ScanCache::lookup( const String_t& path, const FileStamp& stamp ) const
+{
+	std::shared_lock lock( _mx );
+
+	const auto it = _entries.find( path );
+	if( it == _entries.end() || it->second.stamp != stamp ) {
+		_misses++;
+		return {};
+	}
+	_hits++;
+	it->second.generation = _generation;
+	return it->second.included_files;
+}
+
+void ScanCache::store( const String_t& path, const FileStamp& stamp, const std::vector<String_t>& included_files )
+{
+	std::unique_lock lock( _mx );
+
+	auto& entry          = _entries[path];
+	entry.stamp          = stamp;
+	entry.included_files = included_files;
+	entry.generation     = _generation;
+}
+
+std::size_t ScanCache::size() const
+{
+	std::shared_lock lock( _mx );
+	return _entries.size();
+}
+
+fs::path default_cache_location( const fs::path& boost_root )
+{
+	const auto root = fs::absolute( boost_root ).lexically_normal().generic_string();
+
+	char hash[17]{};
+	std::snprintf( hash, sizeof( hash ), "%016llx", static_cast<unsigned long long>( fnv1a( root ) ) );
+	const auto file_name = str_concat( String_t( "scan-" ), String_t( hash ), String_t( ".cache" ) );
+
+	fs::path cache_dir;
+#ifdef _WIN32
+	if( const char* local_app_data = std::getenv( "LOCALAPPDATA" ) ) {
+		cache_dir = fs::path( local_app_data ) / "boost_dep_graph";
+	}
+#else
+	if( const char* xdg_cache = std::getenv( "XDG_CACHE_HOME" ); xdg_cache && *xdg_cache ) {
+		cache_dir = fs::path( xdg_cache ) / "boost_dep_graph";
+	} else if( const char* home = std::getenv( "HOME" ); home && *home ) {
+		cache_dir = fs::path( home ) / ".cache" / "boost_dep_graph";
+	}
+#endif
+
+	if( cache_dir.empty() ) {
+		return boost_root / ".boost_dep_graph.cache";
+	}
+	return cache_dir / file_name;
+}
+
+} // namespace mdev::boostdep
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "utils.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mdev::boostdep {
+
+// Identifies a particular version of a file on disk
+struct FileStamp {
+	std::uint64_t size  = 0;
+	std::int64_t  mtime = 0;
+	std::uint64_t inode = 0; // always 0 on windows
+
+	friend bool operator==( const FileStamp& l, const FileStamp& r )
+	{
+		return l.size == r.size && l.mtime == r.mtime && l.inode == r.inode;
+	}
+	friend bool operator!=( const FileStamp& l, const FileStamp& r ) { return !( l == r ); }
+};
+
+std::optional<FileStamp> get_file_stamp( const std::filesystem::path& file );
+
+/**
+ * Remembers the included files of each scanned file, so a rescan only has to parse files that changed.
+ *
+ * lookup and store may be called concurrently, load and save must not run in parallel to a scan.
+ * Entries that were neither looked up nor stored since the last call to start_scan() are not saved,
+ * so files that disappeared from the tree also disappear from the cache file.
+ */
+class ScanCache {
+public:
+	// replaces the current content. Returns false if file doesn't exist or has an incompatible format
+	bool load( const std::filesystem::path& file );
+	bool save( const std::filesystem::path& file ) const;
+
+	void clear();
+	void start_scan();
+
+	std::optional<std::vector<String_t>> lookup( const String_t& path, const FileStamp& stamp ) const;
+	void store( const String_t& path, const FileStamp& stamp, const std::vector<String_t>& included_files );
+
+	std::size_t size() const;
+	std::size_t hits() const { return _hits; }
+	std::size_t misses() const { return _misses; }
+
+private:
+	struct Entry {
+		FileStamp                          stamp;
+		std::vector<String_t>              included_files;
+		mutable std::atomic<std::uint32_t> generation{0};
+	};
+
+	mutable std::shared_mutex           _mx;
+	std::unordered_map<String_t, Entry> _entries;
+	std::uint32_t                       _generation = 0;
+	mutable std::atomic<std::size_t>    _hits{0};
+	mutable std::atomic<std::size_t>    _misses{0};
+};
+
+// $XDG_CACHE_HOME/boost_dep_graph/... (or the platform equivalent), falling back to a file in boost_root
+std::filesystem::path default_cache_location( const std::filesystem::path& boost_root );
+
+} // namespace mdev::boostdep
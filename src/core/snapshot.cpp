@@ -0,0 +1,113 @@
+#include "snapshot.hpp"
+
+#include "binary_io.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace mdev::boostdep {
+
+namespace {
+
+constexpr std::uint32_t snapshot_format_version = 1;
+constexpr char          snapshot_magic[8]       = {'B', 'D', 'G', 'S', 'N', 'A', 'P', '\0'};
+constexpr std::size_t   header_size             = sizeof( snapshot_magic ) + 2 * sizeof( std::uint32_t );
+static_assert( header_size % binary_alignment == 0 );
+
+// The strings that aren't part of the file graph: the boost root, followed by the module names
+struct StringTable {
+	std::vector<char>          data;
+	std::vector<std::uint32_t> offsets{0};
+
+	void add( std::string_view str )
+	{
+		data.insert( data.end(), str.begin(), str.end() );
+		offsets.push_back( static_cast<std::uint32_t>( data.size() ) );
+	}
+	std::size_t size() const { return offsets.size() - 1; }
+
+	bool is_consistent() const
+	{
+		return !offsets.empty() && offsets.front() == 0 && offsets.back() == data.size()
+			   && std::is_sorted( offsets.begin(), offsets.end() );
+	}
+
+	std::string_view operator[]( std::size_t i ) const
+	{
+		return {data.data() + offsets[i], offsets[i + 1] - offsets[i]};
+	}
+};
+
+} // namespace
+
+bool ScanSnapshot::save( const fs::path& file ) const
+{
+	StringTable               strings;
+	std::vector<std::uint8_t> cmake_flags;
+	strings.add( boost_root.generic_string() );
+	for( const auto& [name, flag] : has_cmake ) {
+		strings.add( name );
+		cmake_flags.push_back( flag ? 1 : 0 );
+	}
+
+	std::ofstream os( file, std::ios::binary | std::ios::trunc );
+	if( !os ) {
+		return false;
+	}
+	const std::uint32_t reserved = 0;
+	os.write( snapshot_magic, sizeof( snapshot_magic ) );
+	os.write( reinterpret_cast<const char*>( &snapshot_format_version ), sizeof( snapshot_format_version ) );
+	os.write( reinterpret_cast<const char*>( &reserved ), sizeof( reserved ) );
+
+	write_array( os, strings.data );
+	write_array( os, strings.offsets );
+	write_array( os, cmake_flags );
+	files.write_arrays( os );
+	return static_cast<bool>( os );
+}
+
+bool ScanSnapshot::load( const fs::path& file )
+{
+	const MappedFile mapping( file );
+	auto             data = mapping.content();
+
+	if( data.size() < header_size
+		|| data.substr( 0, sizeof( snapshot_magic ) ) != std::string_view( snapshot_magic, sizeof( snapshot_magic ) ) ) {
+		return false;
+	}
+	std::uint32_t version = 0;
+	std::memcpy( &version, data.data() + sizeof( snapshot_magic ), sizeof( version ) );
+	if( version != snapshot_format_version ) {
+		return false;
+	}
+	data.remove_prefix( header_size );
+
+	StringTable               strings;
+	std::vector<std::uint8_t> cmake_flags;
+	FileGraph                 g;
+
+	const bool ok = read_array( data, strings.data ) && read_array( data, strings.offsets )
+					&& read_array( data, cmake_flags ) && g.read_arrays( data );
+	if( !ok || !strings.is_consistent() || strings.size() != cmake_flags.size() + 1 ) {
+		return false;
+	}
+
+	std::map<String_t, bool> flags;
+	for( std::size_t i = 0; i < cmake_flags.size(); ++i ) {
+		flags.emplace( strings[i + 1], cmake_flags[i] != 0 );
+	}
+
+	boost_root = fs::path( strings[0] );
+	files      = std::move( g );
+	has_cmake  = std::move( flags );
+	return true;
+}
+
+} // namespace mdev::boostdep
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "file_graph.hpp"
+#include "utils.hpp"
+
+#include <filesystem>
+#include <map>
+
+namespace mdev::boostdep {
+
+/**
+ * Everything the app needs to show the dependency graph of a boost tree without scanning it again:
+ * The scan result, the list of modules and which of them have a CMakeLists.txt.
+ *
+ * On disk, a small versioned header is followed by the arrays, in the same 8 byte aligned layout as FileGraph::save
+ * (see binary_io.hpp). Loading maps the file and copies each array with a single memcpy, so it takes a handful of
+ * allocations but there is no per-record work. The graph is not viewed in place, it owns its arrays.
+ */
+struct ScanSnapshot {
+	std::filesystem::path    boost_root;
+	FileGraph                files;
+	std::map<String_t, bool> has_cmake; // module name -> module has a CMakeLists.txt
+
+	// Returns false if the file can't be written
+	bool save( const std::filesystem::path& file ) const;
+	// Returns false if the file doesn't exist, has another version or is corrupt (*this is unchanged in that case)
+	bool load( const std::filesystem::path& file );
+};
+
+} // namespace mdev::boostdep
@@ -0,0 +1,247 @@
+#include "stats_report.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <ios>
+#include <ostream>
+#include <sstream>
+
+namespace mdev::boostdep {
+
+namespace {
+
+double to_ms( std::chrono::nanoseconds time )
+{
+	return std::chrono::duration<double, std::milli>( time ).count();
+}
+
+// The reports use manipulators, the stream of the caller (e.g. std::cout) gets its formatting back afterwards
+class FormatGuard {
+public:
+	explicit FormatGuard( std::ostream& out )
+		: _out( out )
+		, _flags( out.flags() )
+		, _precision( out.precision() )
+	{
+	}
+	FormatGuard( const FormatGuard& ) = delete;
+	FormatGuard& operator=( const FormatGuard& ) = delete;
+	~FormatGuard()
+	{
+		_out.flags( _flags );
+		_out.precision( _precision );
+	}
+
+private:
+	std::ostream&           _out;
+	std::ios_base::fmtflags _flags;
+	std::streamsize         _precision;
+};
+
+void print_time( std::ostream& out, const char* name, std::chrono::nanoseconds time )
+{
+	out << "  " << std::left << std::setw( 24 ) << name << std::right << std::setw( 12 ) << std::fixed
+		<< std::setprecision( 1 ) << to_ms( time ) << " ms\n";
+}
+
+void print_count( std::ostream& out, const char* name, std::uint64_t count )
+{
+	out << "  " << std::left << std::setw( 24 ) << name << std::right << std::setw( 12 ) << count << '\n';
+}
+
+void append_escaped( std::string& out, std::string_view str )
+{
+	out += '"';
+	for( const char c : str ) {
+		switch( c ) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if( static_cast<unsigned char>( c ) < 0x20 ) {
+					char buffer[8];
+					std::snprintf( buffer, sizeof( buffer ), "\\u%04x", static_cast<unsigned>( c ) );
+					out += buffer;
+				} else {
+					out += c;
+				}
+		}
+	}
+	out += '"';
+}
+
+// Writes "key":value pairs, taking care of the commas
+class JsonObject {
+public:
+	explicit JsonObject( std::string& out )
+		: _out( out )
+	{
+		_out += '{';
+	}
+	~JsonObject() { _out += '}'; }
+
+	std::string& key( std::string_view name )
+	{
+		if( !_first ) {
+			_out += ',';
+		}
+		_first = false;
+		append_escaped( _out, name );
+		_out += ':';
+		return _out;
+	}
+
+	void add( std::string_view name, std::uint64_t value ) { key( name ) += std::to_string( value ); }
+	void add( std::string_view name, std::chrono::nanoseconds time )
+	{
+		std::ostringstream str;
+		str << std::fixed << std::setprecision( 3 ) << to_ms( time );
+		key( name ) += str.str();
+	}
+	void add( std::string_view name, std::string_view value ) { append_escaped( key( name ), value ); }
+
+private:
+	std::string& _out;
+	bool         _first = true;
+};
+
+} // namespace
+
+void print_stats( std::ostream& out, const ScanStats& stats, std::size_t max_modules )
+{
+	const FormatGuard guard( out );
+	out << "Scan:\n";
+	print_time( out, "total", stats.total );
+	print_time( out, "walk (all threads)", stats.walk_time );
+	print_count( out, "files", stats.files );
+	print_count( out, "skipped files", stats.skipped_files );
+	print_count( out, "bytes read", stats.bytes_read );
+	print_count( out, "lines inspected", stats.lines_inspected );
+	print_count( out, "include candidates", stats.include_candidates );
+	print_count( out, "include hits", stats.include_hits );
+
+	std::vector<const ModuleScanStats*> modules;
+	for( const auto& m : stats.modules ) {
+		modules.push_back( &m );
+	}
+	const auto cnt = std::min( max_modules, modules.size() );
+	std::partial_sort( modules.begin(), modules.begin() + cnt, modules.end(), []( const auto* l, const auto* r ) {
+		return l->time > r->time;
+	} );
+	if( cnt != 0 ) {
+		out << "Slowest modules (all threads):\n";
+	}
+	for( std::size_t i = 0; i < cnt; ++i ) {
+		out << "  " << std::left << std::setw( 24 ) << modules[i]->name << std::right << std::setw( 12 ) << std::fixed
+			<< std::setprecision( 1 ) << to_ms( modules[i]->time ) << " ms " << std::setw( 8 ) << modules[i]->files
+			<< " files\n";
+	}
+}
+
+void print_stats( std::ostream& out, const AnalysisStats& stats )
+{
+	const FormatGuard guard( out );
+	out << "Analysis:\n";
+	print_time( out, "total", stats.total );
+	print_time( out, "file index", stats.index_time );
+	print_time( out, "filter", stats.filter_time );
+	print_time( out, "dependency map", stats.dep_map_time );
+	print_time( out, "transitive closure", stats.closure_time );
+	print_time( out, "module levels", stats.level_time );
+	print_count( out, "files", stats.files );
+	print_count( out, "nodes", stats.nodes );
+	print_count( out, "resolved includes", stats.resolved_includes );
+	print_count( out, "unresolved includes", stats.unresolved_includes );
+	print_count( out, "distinct unresolved", stats.unresolved.size() );
+}
+
+void print_unresolved_includes( std::ostream& out, const UnresolvedIncludes& unresolved, std::size_t max_entries )
+{
+	if( unresolved.empty() ) {
+		return;
+	}
+	const FormatGuard guard( out );
+
+	auto entries = unresolved.entries();
+	std::stable_sort( entries.begin(), entries.end(), []( const auto& l, const auto& r ) { return l.count > r.count; } );
+
+	out << "Unresolved includes: " << unresolved.total() << " (" << entries.size() << " distinct)\n";
+	const auto cnt = std::min( max_entries, entries.size() );
+	for( std::size_t i = 0; i < cnt; ++i ) {
+		out << "  " << std::right << std::setw( 6 ) << entries[i].count << "  " << std::left << std::setw( 24 )
+			<< entries[i].module << ' ' << entries[i].header << '\n';
+	}
+	if( cnt < entries.size() ) {
+		out << "  ... and " << entries.size() - cnt << " more\n";
+	}
+}
+
+std::string to_json( const ScanStats& stats )
+{
+	std::string ret;
+	{
+		JsonObject obj( ret );
+		obj.add( "total_ms", stats.total );
+		obj.add( "walk_ms", stats.walk_time );
+		obj.add( "files", stats.files );
+		obj.add( "skipped_files", stats.skipped_files );
+		obj.add( "bytes_read", stats.bytes_read );
+		obj.add( "lines_inspected", stats.lines_inspected );
+		obj.add( "include_candidates", stats.include_candidates );
+		obj.add( "include_hits", stats.include_hits );
+
+		auto& modules = obj.key( "modules" );
+		modules += '[';
+		for( std::size_t i = 0; i < stats.modules.size(); ++i ) {
+			if( i != 0 ) {
+				modules += ',';
+			}
+			JsonObject m( modules );
+			m.add( "name", stats.modules[i].name );
+			m.add( "files", stats.modules[i].files );
+			m.add( "time_ms", stats.modules[i].time );
+		}
+		modules += ']';
+	}
+	return ret;
+}
+
+std::string to_json( const AnalysisStats& stats )
+{
+	std::string ret;
+	{
+		JsonObject obj( ret );
+		obj.add( "total_ms", stats.total );
+		obj.add( "index_ms", stats.index_time );
+		obj.add( "sort_ms", stats.index_time ); // name before the FileIndex replaced sorting, kept for old consumers
+		obj.add( "filter_ms", stats.filter_time );
+		obj.add( "dep_map_ms", stats.dep_map_time );
+		obj.add( "closure_ms", stats.closure_time );
+		obj.add( "level_ms", stats.level_time );
+		obj.add( "files", stats.files );
+		obj.add( "nodes", stats.nodes );
+		obj.add( "resolved_includes", stats.resolved_includes );
+		obj.add( "unresolved_includes", stats.unresolved_includes );
+
+		auto& unresolved = obj.key( "unresolved" );
+		unresolved += '[';
+		bool first = true;
+		for( const auto& entry : stats.unresolved.entries() ) {
+			if( !first ) {
+				unresolved += ',';
+			}
+			first = false;
+			JsonObject e( unresolved );
+			e.add( "module", entry.module );
+			e.add( "header", entry.header );
+			e.add( "count", static_cast<std::uint64_t>( entry.count ) );
+		}
+		unresolved += ']';
+	}
+	return ret;
+}
+
+} // namespace mdev::boostdep
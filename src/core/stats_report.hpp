@@ -0,0 +1,22 @@
+#pragma once
+
+#include "boostdep.hpp"
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+namespace mdev::boostdep {
+
+// Human readable tables (one line per phase, followed by the slowest modules of the scan)
+void print_stats( std::ostream& out, const ScanStats& stats, std::size_t max_modules = 10 );
+void print_stats( std::ostream& out, const AnalysisStats& stats );
+
+// Summary of the unresolved includes, the most frequent (module, header) pairs first
+void print_unresolved_includes( std::ostream& out, const UnresolvedIncludes& unresolved, std::size_t max_entries = 20 );
+
+// Single JSON objects, times are in milliseconds
+std::string to_json( const ScanStats& stats );
+std::string to_json( const AnalysisStats& stats );
+
+} // namespace mdev::boostdep
@@ -0,0 +1,134 @@
+#include "string_pool.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+namespace mdev {
+
+namespace {
+
+constexpr std::size_t block_size = 64 * 1024;
+
+} // namespace
+
+std::string_view StringPool::Shard::store( std::string_view str )
+{
+	if( str.empty() ) {
+		return {};
+	}
+	if( str.size() > block_free ) {
+		// big strings get their own block, so we don't waste the rest of the current one
+		if( str.size() > block_size / 4 ) {
+			blocks.insert( blocks.begin(), std::make_unique<char[]>( str.size() ) );
+			std::memcpy( blocks.front().get(), str.data(), str.size() );
+			bytes += str.size();
+			return {blocks.front().get(), str.size()};
+		}
+		blocks.push_back( std::make_unique<char[]>( block_size ) );
+		block_free = block_size;
+		bytes += block_size;
+	}
+
+	char* dest = blocks.back().get() + ( block_size - block_free );
+	std::memcpy( dest, str.data(), str.size() );
+	block_free -= str.size();
+	return {dest, str.size()};
+}
+
+StringPool::StringPool()
+	: _chunks( new std::atomic<std::string_view*>[max_chunks] )
+{
+	for( std::size_t i = 0; i < max_chunks; ++i ) {
+		_chunks[i] = nullptr;
+	}
+}
+
+StringPool::~StringPool()
+{
+	for( std::size_t i = 0; i < max_chunks; ++i ) {
+		delete[] _chunks[i].load();
+	}
+}
+
+std::string_view* StringPool::get_or_create_chunk( std::size_t idx )
+{
+	if( idx >= max_chunks ) {
+		throw std::length_error( "StringPool: too many symbols" );
+	}
+
+	auto* chunk = _chunks[idx].load( std::memory_order_acquire );
+	if( chunk == nullptr ) {
+		// multiple shards might race to create the same chunk
+		auto* new_chunk = new std::string_view[chunk_size];
+		if( _chunks[idx].compare_exchange_strong( chunk, new_chunk, std::memory_order_acq_rel ) ) {
+			chunk = new_chunk;
+		} else {
+			delete[] new_chunk;
+		}
+	}
+	return chunk;
+}
+
+Symbol StringPool::intern( std::string_view str )
+{
+	const auto hash  = std::hash<std::string_view>{}( str );
+	auto&      shard = _shards[hash % shard_cnt];
+
+	std::lock_guard lg( shard.mx );
+
+	const auto it = shard.map.find( str );
+	if( it != shard.map.end() ) {
+		return it->second;
+	}
+
+	const auto stored = shard.store( str );
+	const auto sym    = static_cast<Symbol>( _size.fetch_add( 1 ) );
+
+	get_or_create_chunk( sym >> chunk_bits )[sym & ( chunk_size - 1 )] = stored;
+	shard.map.emplace( stored, sym );
+	return sym;
+}
+
+std::optional<Symbol> StringPool::find( std::string_view str ) const
+{
+	const auto hash  = std::hash<std::string_view>{}( str );
+	auto&      shard = _shards[hash % shard_cnt];
+
+	std::lock_guard lg( shard.mx );
+
+	const auto it = shard.map.find( str );
+	if( it == shard.map.end() ) {
+		return {};
+	}
+	return it->second;
+}
+
+std::string_view StringPool::view( Symbol sym ) const
+{
+	assert( sym < _size );
+	return _chunks[sym >> chunk_bits].load( std::memory_order_acquire )[sym & ( chunk_size - 1 )];
+}
+
+std::size_t StringPool::memory_usage() const
+{
+	std::size_t bytes = 0;
+	for( const auto& shard : _shards ) {
+		std::lock_guard lg( shard.mx );
+		bytes += shard.bytes;
+		// rough estimate for the hash map nodes and buckets
+		bytes += shard.map.size() * ( sizeof( std::string_view ) + sizeof( Symbol ) + 2 * sizeof( void* ) )
+				 + shard.map.bucket_count() * sizeof( void* );
+	}
+	const auto chunk_cnt = ( _size + chunk_size - 1 ) / chunk_size;
+	return bytes + chunk_cnt * chunk_size * sizeof( std::string_view ) + max_chunks * sizeof( void* );
+}
+
+StringPool& global_string_pool()
+{
+	static StringPool pool;
+	return pool;
+}
+
+} // namespace mdev
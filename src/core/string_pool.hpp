@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mdev {
+
+// Handle for an interned string. Symbols are handed out densely starting at 0 and never change
+using Symbol = std::uint32_t;
+
+constexpr Symbol invalid_symbol = ~Symbol{0};
+
+/**
+ * Thread safe string interning table.
+ *
+ * intern() is sharded by hash, so concurrent calls rarely contend.
+ * view() is lock free and the returned string_view stays valid for the lifetime of the pool.
+ */
+class StringPool {
+public:
+	StringPool();
+	StringPool( const StringPool& ) = delete;
+	StringPool& operator=( const StringPool& ) = delete;
+	~StringPool();
+
+	Symbol                intern( std::string_view str );
+	std::optional<Symbol> find( std::string_view str ) const;
+	std::string_view      view( Symbol sym ) const;
+
+	std::size_t size() const { return _size; }
+	// approximate number of bytes allocated by the pool
+	std::size_t memory_usage() const;
+
+private:
+	static constexpr std::size_t shard_cnt  = 16;
+	static constexpr std::size_t chunk_bits = 12;
+	static constexpr std::size_t chunk_size = std::size_t{1} << chunk_bits;
+	static constexpr std::size_t max_chunks = 16 * 1024; // => 64M symbols
+
+	struct Shard {
+		mutable std::mutex                           mx;
+		std::unordered_map<std::string_view, Symbol> map;
+		std::vector<std::unique_ptr<char[]>>         blocks;
+		std::size_t                                  block_free = 0;
+		std::size_t                                  bytes      = 0;
+
+		std::string_view store( std::string_view str );
+	};
+
+	std::string_view* get_or_create_chunk( std::size_t idx );
+
+	std::array<Shard, shard_cnt>                      _shards;
+	std::unique_ptr<std::atomic<std::string_view*>[]> _chunks;
+	std::atomic<std::size_t>                          _size{0};
+};
+
+// The pool used by default for everything that gets scanned
+StringPool& global_string_pool();
+
+} // namespace mdev
@@ -0,0 +1,164 @@
+#include "task_scheduler.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+namespace mdev {
+
+namespace {
+
+struct CurrentWorker {
+	const TaskScheduler* scheduler = nullptr;
+	std::size_t          index     = 0;
+};
+
+thread_local CurrentWorker current_worker;
+
+// A scheduler can be run from within a task of another one, so the outer value has to come back afterwards
+class CurrentWorkerGuard {
+public:
+	explicit CurrentWorkerGuard( CurrentWorker worker )
+		: _previous( std::exchange( current_worker, worker ) )
+	{
+	}
+	CurrentWorkerGuard( const CurrentWorkerGuard& ) = delete;
+	CurrentWorkerGuard& operator=( const CurrentWorkerGuard& ) = delete;
+	~CurrentWorkerGuard() { current_worker = _previous; }
+
+private:
+	CurrentWorker _previous;
+};
+
+} // namespace
+
+TaskScheduler::TaskScheduler( std::size_t thread_count )
+{
+	if( thread_count == 0 ) {
+		thread_count = std::max( 1u, std::thread::hardware_concurrency() );
+	}
+	for( std::size_t i = 0; i < thread_count; ++i ) {
+		_queues.push_back( std::make_unique<Queue>() );
+	}
+}
+
+TaskScheduler::~TaskScheduler() = default;
+
+bool TaskScheduler::in_worker() const
+{
+	return current_worker.scheduler == this;
+}
+
+void TaskScheduler::spawn( Task task )
+{
+	// tasks spawned by a worker go to its own queue, everything else is distributed round robin
+	const std::size_t idx = current_worker.scheduler == this ? current_worker.index
+															 : _next_queue++ % _queues.size();
+
+	_pending++;
+	std::lock_guard lg( _queues[idx]->mx );
+	_queues[idx]->tasks.push_back( std::move( task ) );
+}
+
+bool TaskScheduler::pop( std::size_t worker, Task& task )
+{
+	auto&           q = *_queues[worker];
+	std::lock_guard lg( q.mx );
+	if( q.tasks.empty() ) {
+		return false;
+	}
+	task = std::move( q.tasks.back() );
+	q.tasks.pop_back();
+	return true;
+}
+
+bool TaskScheduler::steal( std::size_t worker, Task& task )
+{
+	const auto cnt = _queues.size();
+	for( std::size_t i = 1; i < cnt; ++i ) {
+		auto&           q = *_queues[( worker + i ) % cnt];
+		std::lock_guard lg( q.mx );
+		if( !q.tasks.empty() ) {
+			task = std::move( q.tasks.front() );
+			q.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void TaskScheduler::worker_loop( std::size_t worker, WorkerStats& stats )
+{
+	const CurrentWorkerGuard guard( {this, worker} );
+
+	using clock = std::chrono::steady_clock;
+
+	int  idle_rounds = 0;
+	Task task;
+	while( _pending != 0 ) {
+		bool found = pop( worker, task );
+		if( !found && steal( worker, task ) ) {
+			found = true;
+			stats.steals++;
+		}
+		if( !found ) {
+			// Someone is still working and might spawn new tasks
+			if( ++idle_rounds < 64 ) {
+				std::this_thread::yield();
+			} else {
+				std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+			}
+			continue;
+		}
+		idle_rounds = 0;
+
+		const auto start = clock::now();
+		try {
+			task( worker );
+		} catch( ... ) {
+			std::lock_guard lg( _error_mx );
+			if( !_error ) {
+				_error = std::current_exception();
+			}
+		}
+		task = nullptr;
+		stats.busy += clock::now() - start;
+		stats.tasks++;
+
+		_pending--;
+	}
+}
+
+std::vector<WorkerStats> TaskScheduler::run()
+{
+	std::vector<WorkerStats> stats( _queues.size() );
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for( std::size_t i = 1; i < _queues.size(); ++i ) {
+		threads.emplace_back( [this, i, &stats] { worker_loop( i, stats[i] ); } );
+	}
+	worker_loop( 0, stats[0] );
+	for( auto& t : threads ) {
+		t.join();
+	}
+
+	const auto total = std::chrono::steady_clock::now() - start;
+	for( auto& s : stats ) {
+		s.total = total;
+	}
+
+	if( _error ) {
+		std::rethrow_exception( std::exchange( _error, nullptr ) );
+	}
+	return stats;
+}
+
+std::size_t useful_thread_count( std::size_t count, std::size_t min_items_per_thread )
+{
+	const std::size_t hw = std::max( 1u, std::thread::hardware_concurrency() );
+	return std::clamp<std::size_t>( count / std::max<std::size_t>( min_items_per_thread, 1 ), 1, hw );
+}
+
+} // namespace mdev
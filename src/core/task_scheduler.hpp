@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mdev {
+
+struct WorkerStats {
+	std::size_t              tasks  = 0;
+	std::size_t              steals = 0;
+	std::chrono::nanoseconds busy{0};  // time spent executing tasks
+	std::chrono::nanoseconds total{0}; // wall time of the whole run
+
+	double utilization() const { return total.count() == 0 ? 0.0 : double( busy.count() ) / double( total.count() ); }
+};
+
+/**
+ * Work stealing scheduler for a batch of tasks that may spawn further tasks.
+ *
+ * Each worker has its own queue: It pushes and pops new tasks at the back (depth first, cache friendly),
+ * while idle workers steal the oldest tasks from the front of other queues (those tend to be the big ones).
+ * run() executes all tasks to completion, with the calling thread acting as worker 0.
+ */
+class TaskScheduler {
+public:
+	// worker index is in [0, thread_count())
+	using Task = std::function<void( std::size_t worker )>;
+
+	// thread_count == 0 means std::thread::hardware_concurrency()
+	explicit TaskScheduler( std::size_t thread_count = 0 );
+	~TaskScheduler();
+
+	std::size_t thread_count() const { return _queues.size(); }
+
+	// true while the calling thread executes a task of this scheduler
+	bool in_worker() const;
+
+	// Can be called before run() and from within running tasks
+	void spawn( Task task );
+
+	// Returns once all tasks are done. If a task throws, the first exception is rethrown here
+	std::vector<WorkerStats> run();
+
+private:
+	struct Queue {
+		std::mutex       mx;
+		std::deque<Task> tasks;
+	};
+
+	void worker_loop( std::size_t worker, WorkerStats& stats );
+	bool pop( std::size_t worker, Task& task );
+	bool steal( std::size_t worker, Task& task );
+
+	std::vector<std::unique_ptr<Queue>> _queues;
+	std::atomic<std::size_t>            _pending{0};
+	std::atomic<std::size_t>            _next_queue{0};
+
+	std::mutex         _error_mx;
+	std::exception_ptr _error;
+};
+
+// Threads worth starting for count work items if every thread should get at least min_items_per_thread of them
+// (1 for small inputs, at most std::thread::hardware_concurrency())
+std::size_t useful_thread_count( std::size_t count, std::size_t min_items_per_thread );
+
+} // namespace mdev
@@ -0,0 +1,209 @@
+#include "tree_watcher.hpp"
+
+#include <system_error>
+
+// clang-format off
+#ifdef __linux__
+	#include <cerrno>
+	#include <poll.h>
+	#include <sys/eventfd.h>
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#endif
+// clang-format on
+
+namespace fs = std::filesystem;
+
+namespace mdev::boostdep {
+
+TreeWatcher::~TreeWatcher()
+{
+	stop();
+}
+
+TreeWatcher::Changes TreeWatcher::take_changes()
+{
+	std::lock_guard lg( _mx );
+
+	Changes ret;
+	ret.paths.assign( _changed_paths.begin(), _changed_paths.end() );
+	ret.overflow = _overflow;
+
+	_changed_paths.clear();
+	_overflow = false;
+	return ret;
+}
+
+#ifdef __linux__
+
+namespace {
+
+constexpr std::uint32_t watch_mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+									 | IN_DELETE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW;
+
+// Editors typically generate a couple of events when saving a file (e.g. write temp file + rename).
+// We wait until there was no new event for this long before notifying anyone
+constexpr int quiet_period_ms = 15;
+
+} // namespace
+
+bool TreeWatcher::is_supported()
+{
+	return true;
+}
+
+bool TreeWatcher::start( const std::vector<fs::path>& dirs, std::function<void()> on_change )
+{
+	stop();
+
+	_inotify_fd = ::inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	_stop_fd    = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+	if( _inotify_fd < 0 || _stop_fd < 0 ) {
+		stop();
+		return false;
+	}
+
+	_on_change      = std::move( on_change );
+	_failed_watches = 0;
+	_watched_dirs.clear();
+	for( const auto& dir : dirs ) {
+		add_watches( dir );
+	}
+
+	_thread = std::thread( [this] { run(); } );
+	return true;
+}
+
+void TreeWatcher::stop()
+{
+	if( _thread.joinable() ) {
+		const std::uint64_t one = 1;
+		[[maybe_unused]] auto r = ::write( _stop_fd, &one, sizeof( one ) );
+		_thread.join();
+	}
+	if( _inotify_fd >= 0 ) {
+		::close( _inotify_fd );
+		_inotify_fd = -1;
+	}
+	if( _stop_fd >= 0 ) {
+		::close( _stop_fd );
+		_stop_fd = -1;
+	}
+}
+
+void TreeWatcher::add_watches( const fs::path& dir )
+{
+	// inotify isn't recursive, so every directory needs its own watch
+	std::error_code ec;
+	if( !fs::is_directory( fs::symlink_status( dir, ec ) ) ) {
+		return;
+	}
+
+	const auto add = [this]( const fs::path& d ) {
+		const int wd = ::inotify_add_watch( _inotify_fd, d.c_str(), watch_mask );
+		if( wd < 0 ) {
+			if( errno != ENOENT ) {
+				_failed_watches++;
+			}
+			return;
+		}
+		if( static_cast<std::size_t>( wd ) >= _watched_dirs.size() ) {
+			_watched_dirs.resize( wd + 1 );
+		}
+		_watched_dirs[wd] = d;
+	};
+
+	add( dir );
+	for( auto it = fs::recursive_directory_iterator( dir, ec ); !ec && it != fs::recursive_directory_iterator();
+		 it.increment( ec ) ) {
+		if( it->is_directory( ec ) && !it->is_symlink( ec ) ) {
+			add( it->path() );
+		}
+	}
+}
+
+void TreeWatcher::run()
+{
+	alignas( inotify_event ) char buffer[64 * 1024];
+
+	bool pending = false;
+	while( true ) {
+		pollfd fds[2] = {{_inotify_fd, POLLIN, 0}, {_stop_fd, POLLIN, 0}};
+
+		const int r = ::poll( fds, 2, pending ? quiet_period_ms : -1 );
+		if( r < 0 ) {
+			if( errno == EINTR ) {
+				continue;
+			}
+			break;
+		}
+		if( fds[1].revents != 0 ) {
+			break;
+		}
+		if( r == 0 ) {
+			pending = false;
+			if( _on_change ) {
+				_on_change();
+			}
+			continue;
+		}
+
+		while( true ) {
+			const auto len = ::read( _inotify_fd, buffer, sizeof( buffer ) );
+			if( len <= 0 ) {
+				break; // EAGAIN: all queued events processed
+			}
+
+			for( const char* p = buffer; p < buffer + len; ) {
+				const auto* ev = reinterpret_cast<const inotify_event*>( p );
+				p += sizeof( inotify_event ) + ev->len;
+
+				if( ev->mask & IN_Q_OVERFLOW ) {
+					std::lock_guard lg( _mx );
+					_overflow = true;
+					continue;
+				}
+				if( ev->wd < 0 || static_cast<std::size_t>( ev->wd ) >= _watched_dirs.size()
+					|| _watched_dirs[ev->wd].empty() ) {
+					continue;
+				}
+				if( ev->mask & IN_IGNORED ) {
+					_watched_dirs[ev->wd].clear(); // watch was removed (e.g. directory got deleted)
+					continue;
+				}
+
+				const fs::path path = ev->len > 0 ? _watched_dirs[ev->wd] / ev->name : _watched_dirs[ev->wd];
+
+				if( ( ev->mask & IN_ISDIR ) && ( ev->mask & ( IN_CREATE | IN_MOVED_TO ) ) ) {
+					add_watches( path );
+				}
+
+				std::lock_guard lg( _mx );
+				_changed_paths.insert( path );
+			}
+		}
+		pending = true;
+	}
+}
+
+#else
+
+bool TreeWatcher::is_supported()
+{
+	return false;
+}
+
+bool TreeWatcher::start( const std::vector<fs::path>&, std::function<void()> )
+{
+	return false;
+}
+
+void TreeWatcher::stop() {}
+
+void TreeWatcher::add_watches( const fs::path& ) {}
+
+void TreeWatcher::run() {}
+
+#endif
+
+} // namespace mdev::boostdep
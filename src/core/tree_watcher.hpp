@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace mdev::boostdep {
+
+/**
+ * Watches directory trees for changes in a background thread (inotify based - only supported on linux).
+ *
+ * Changed, created or removed files and directories are collected until they are fetched via take_changes().
+ * on_change is called from the watcher thread (after a short quiet period, so a burst of events
+ * only results in a single notification) and should only schedule the processing of the changes.
+ */
+class TreeWatcher {
+public:
+	struct Changes {
+		std::vector<std::filesystem::path> paths;
+		// Some events got lost (e.g. the kernel queue overflowed) - only a full rescan is reliable
+		bool overflow = false;
+	};
+
+	TreeWatcher() = default;
+	TreeWatcher( const TreeWatcher& ) = delete;
+	TreeWatcher& operator=( const TreeWatcher& ) = delete;
+	~TreeWatcher();
+
+	static bool is_supported();
+
+	// Stops any previous watch. Returns false if watching isn't possible
+	bool start( const std::vector<std::filesystem::path>& dirs, std::function<void()> on_change );
+	void stop();
+	bool is_running() const { return _thread.joinable(); }
+
+	Changes take_changes();
+
+	// number of directories that couldn't be watched (e.g. because the inotify watch limit was reached)
+	std::size_t failed_watch_count() const { return _failed_watches; }
+
+private:
+	void run();
+	void add_watches( const std::filesystem::path& dir );
+
+	int _inotify_fd = -1;
+	int _stop_fd    = -1;
+
+	std::function<void()>    _on_change;
+	std::thread              _thread;
+	std::atomic<std::size_t> _failed_watches{0};
+
+	// only accessed from the watcher thread once it is running
+	std::vector<std::filesystem::path> _watched_dirs; // indexed by watch descriptor
+
+	std::mutex                      _mx;
+	std::set<std::filesystem::path> _changed_paths;
+	bool                            _overflow = false;
+};
+
+} // namespace mdev::boostdep
@@ -0,0 +1,389 @@
+#include "uring_reader.hpp"
+
+#include "mapped_file.hpp"
+
+// clang-format off
+#ifdef __linux__
+	#include <linux/io_uring.h>
+
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+
+	#include <algorithm>
+	#include <cerrno>
+	#include <cstring>
+	#include <system_error>
+#endif
+// clang-format on
+
+namespace mdev {
+
+void UringReader::read_files_sync( const std::vector<std::filesystem::path>& files, const Callback& on_read )
+{
+	for( std::size_t i = 0; i < files.size(); ++i ) {
+		const MappedFile mapping( files[i] );
+		on_read( i, mapping.content() );
+	}
+}
+
+void UringReader::read_files( const std::vector<std::filesystem::path>& files, const Callback& on_read )
+{
+	if( is_async() ) {
+		read_files_async( files, on_read );
+	} else {
+		read_files_sync( files, on_read );
+	}
+}
+
+#ifdef __linux__
+
+namespace {
+
+// Most headers are smaller than this. Bigger files need additional reads (the buffer grows as necessary)
+constexpr std::size_t initial_buffer_size = 16 * 1024;
+
+constexpr std::uint64_t close_tag = ~std::uint64_t{0};
+
+int sys_io_uring_setup( unsigned entries, io_uring_params* params )
+{
+	return static_cast<int>( ::syscall( __NR_io_uring_setup, entries, params ) );
+}
+
+int sys_io_uring_enter( int fd, unsigned to_submit, unsigned min_complete, unsigned flags )
+{
+	return static_cast<int>( ::syscall( __NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0 ) );
+}
+
+int sys_io_uring_register( int fd, unsigned opcode, void* arg, unsigned nr_args )
+{
+	return static_cast<int>( ::syscall( __NR_io_uring_register, fd, opcode, arg, nr_args ) );
+}
+
+// openat, read and close are only supported since linux 5.6
+bool supports_required_ops( int ring_fd )
+{
+	constexpr unsigned op_cnt = 64;
+
+	std::vector<char> storage( sizeof( io_uring_probe ) + op_cnt * sizeof( io_uring_probe_op ) );
+	auto*             probe = reinterpret_cast<io_uring_probe*>( storage.data() );
+	if( sys_io_uring_register( ring_fd, IORING_REGISTER_PROBE, probe, op_cnt ) < 0 ) {
+		return false;
+	}
+	for( auto op : {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE} ) {
+		if( op > probe->last_op || !( probe->ops[op].flags & IO_URING_OP_SUPPORTED ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void* map_ring( int ring_fd, std::size_t size, std::uint64_t offset )
+{
+	void* ptr = ::mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset );
+	return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+template<class T>
+T* at_offset( void* base, std::uint32_t offset )
+{
+	return reinterpret_cast<T*>( static_cast<char*>( base ) + offset );
+}
+
+} // namespace
+
+UringReader::UringReader( unsigned queue_depth )
+{
+	if( !setup( queue_depth ) ) {
+		teardown();
+	}
+}
+
+UringReader::~UringReader()
+{
+	teardown();
+}
+
+bool UringReader::is_supported()
+{
+	static const bool supported = [] { return UringReader( 1 ).is_async(); }();
+	return supported;
+}
+
+bool UringReader::setup( unsigned queue_depth )
+{
+	// every slot has at most one open/read in flight, plus the closes that were queued in the meantime
+	io_uring_params params{};
+	_ring_fd = sys_io_uring_setup( 2 * queue_depth, &params );
+	if( _ring_fd < 0 || !supports_required_ops( _ring_fd ) ) {
+		return false;
+	}
+
+	_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+	_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+	if( params.features & IORING_FEAT_SINGLE_MMAP ) {
+		_sq_ring_size = _cq_ring_size = std::max( _sq_ring_size, _cq_ring_size );
+	}
+
+	_sq_ring = map_ring( _ring_fd, _sq_ring_size, IORING_OFF_SQ_RING );
+	if( _sq_ring == nullptr ) {
+		return false;
+	}
+	if( params.features & IORING_FEAT_SINGLE_MMAP ) {
+		_cq_ring = _sq_ring;
+	} else {
+		_cq_ring = map_ring( _ring_fd, _cq_ring_size, IORING_OFF_CQ_RING );
+		if( _cq_ring == nullptr ) {
+			return false;
+		}
+	}
+	_sqes_size = params.sq_entries * sizeof( io_uring_sqe );
+	_sqes      = map_ring( _ring_fd, _sqes_size, IORING_OFF_SQES );
+	if( _sqes == nullptr ) {
+		return false;
+	}
+
+	_sq_head    = at_offset<unsigned>( _sq_ring, params.sq_off.head );
+	_sq_tail    = at_offset<unsigned>( _sq_ring, params.sq_off.tail );
+	_sq_mask    = *at_offset<unsigned>( _sq_ring, params.sq_off.ring_mask );
+	_sq_array   = at_offset<unsigned>( _sq_ring, params.sq_off.array );
+	_cq_head    = at_offset<unsigned>( _cq_ring, params.cq_off.head );
+	_cq_tail    = at_offset<unsigned>( _cq_ring, params.cq_off.tail );
+	_cq_mask    = *at_offset<unsigned>( _cq_ring, params.cq_off.ring_mask );
+	_cqes       = at_offset<void>( _cq_ring, params.cq_off.cqes );
+	_local_tail = *_sq_tail;
+
+	_slots.resize( queue_depth );
+	return true;
+}
+
+void UringReader::teardown()
+{
+	if( _sqes ) {
+		::munmap( _sqes, _sqes_size );
+	}
+	if( _cq_ring && _cq_ring != _sq_ring ) {
+		::munmap( _cq_ring, _cq_ring_size );
+	}
+	if( _sq_ring ) {
+		::munmap( _sq_ring, _sq_ring_size );
+	}
+	if( _ring_fd >= 0 ) {
+		::close( _ring_fd );
+	}
+	_sqes = _cq_ring = _sq_ring = nullptr;
+	_ring_fd                    = -1;
+	_slots.clear();
+}
+
+void UringReader::push_open( std::uint32_t slot )
+{
+	const unsigned idx = _local_tail & _sq_mask;
+	auto&          sqe = static_cast<io_uring_sqe*>( _sqes )[idx];
+	std::memset( &sqe, 0, sizeof( sqe ) );
+	sqe.opcode     = IORING_OP_OPENAT;
+	sqe.fd         = AT_FDCWD;
+	sqe.addr       = reinterpret_cast<std::uint64_t>( _slots[slot].path.c_str() );
+	sqe.open_flags = O_RDONLY | O_CLOEXEC;
+	sqe.user_data  = slot;
+
+	_sq_array[idx] = idx;
+	_local_tail++;
+}
+
+void UringReader::push_read( std::uint32_t slot )
+{
+	auto& s = _slots[slot];
+	if( s.buffer.size() == s.size ) {
+		s.buffer.resize( std::max( initial_buffer_size, 2 * s.buffer.size() ) );
+	}
+
+	const unsigned idx = _local_tail & _sq_mask;
+	auto&          sqe = static_cast<io_uring_sqe*>( _sqes )[idx];
+	std::memset( &sqe, 0, sizeof( sqe ) );
+	sqe.opcode    = IORING_OP_READ;
+	sqe.fd        = s.fd;
+	sqe.addr      = reinterpret_cast<std::uint64_t>( s.buffer.data() + s.size );
+	sqe.len       = static_cast<std::uint32_t>( s.buffer.size() - s.size );
+	sqe.off       = s.size;
+	sqe.user_data = slot;
+
+	_sq_array[idx] = idx;
+	_local_tail++;
+}
+
+void UringReader::push_close( int fd )
+{
+	const unsigned idx = _local_tail & _sq_mask;
+	auto&          sqe = static_cast<io_uring_sqe*>( _sqes )[idx];
+	std::memset( &sqe, 0, sizeof( sqe ) );
+	sqe.opcode    = IORING_OP_CLOSE;
+	sqe.fd        = fd;
+	sqe.user_data = close_tag;
+
+	_sq_array[idx] = idx;
+	_local_tail++;
+}
+
+void UringReader::submit_and_wait()
+{
+	__atomic_store_n( _sq_tail, _local_tail, __ATOMIC_RELEASE );
+	const unsigned to_submit = _local_tail - __atomic_load_n( _sq_head, __ATOMIC_ACQUIRE );
+
+	// EINTR: nothing happened, EBUSY/EAGAIN: completions have to be reaped first - both are fine to just return
+	if( sys_io_uring_enter( _ring_fd, to_submit, 1, IORING_ENTER_GETEVENTS ) < 0 && errno != EINTR && errno != EBUSY
+		&& errno != EAGAIN ) {
+		throw std::system_error( errno, std::generic_category(), "io_uring_enter failed" );
+	}
+}
+
+void UringReader::read_files_async( const std::vector<std::filesystem::path>& files, const Callback& on_read )
+{
+	std::vector<std::uint32_t> free_slots;
+	for( std::uint32_t i = static_cast<std::uint32_t>( _slots.size() ); i-- > 0; ) {
+		free_slots.push_back( i );
+	}
+
+	std::size_t next_file = 0;
+	std::size_t pending   = 0; // includes the closes, so all of them are done when we return
+
+	// If on_read throws, the requests that are still in flight must not end up in the buffers of the next batch
+	struct AbortGuard {
+		UringReader*       reader;
+		const std::size_t& pending;
+		bool               done = false;
+		~AbortGuard()
+		{
+			if( !done ) {
+				reader->abort_batch( pending );
+			}
+		}
+	} guard{this, pending, false};
+
+	const auto finish = [&]( std::uint32_t slot, std::string_view content ) {
+		auto& s = _slots[slot];
+		on_read( s.file_index, content );
+		if( s.fd >= 0 ) {
+			push_close( s.fd );
+			pending++;
+		}
+		s.fd   = -1;
+		s.size = 0;
+		free_slots.push_back( slot );
+	};
+
+	while( next_file < files.size() || pending != 0 ) {
+		// the submission queue can't overflow: At most one request per slot plus the closes since the last submit
+		while( next_file < files.size() && !free_slots.empty() ) {
+			const auto slot = free_slots.back();
+			free_slots.pop_back();
+
+			auto& s      = _slots[slot];
+			s.file_index = next_file;
+			s.path       = files[next_file].string();
+			push_open( slot );
+			pending++;
+			next_file++;
+		}
+
+		submit_and_wait();
+
+		unsigned head = *_cq_head;
+		while( head != __atomic_load_n( _cq_tail, __ATOMIC_ACQUIRE ) ) {
+			const auto cqe = static_cast<const io_uring_cqe*>( _cqes )[head & _cq_mask];
+			// consumed right away, so an exception from on_read doesn't leave it in the ring
+			__atomic_store_n( _cq_head, ++head, __ATOMIC_RELEASE );
+			pending--;
+
+			if( cqe.user_data == close_tag ) {
+				continue;
+			}
+
+			const auto slot = static_cast<std::uint32_t>( cqe.user_data );
+			auto&      s    = _slots[slot];
+			if( cqe.res < 0 ) {
+				finish( slot, {} );
+			} else if( s.fd < 0 ) { // file was just opened
+				s.fd = cqe.res;
+				push_read( slot );
+				pending++;
+			} else if( cqe.res == 0 ) { // end of file
+				finish( slot, {s.buffer.data(), s.size} );
+			} else {
+				// Short reads are legal (e.g. on NFS / FUSE), so only 0 means end of file.
+				// push_read continues at the new offset and grows the buffer if it is full
+				s.size += static_cast<std::size_t>( cqe.res );
+				push_read( slot );
+				pending++;
+			}
+		}
+	}
+	guard.done = true;
+}
+
+void UringReader::abort_batch( std::size_t pending ) noexcept
+{
+	const auto close_files = [&] {
+		for( auto& s : _slots ) {
+			if( s.fd >= 0 ) {
+				::close( s.fd );
+			}
+			s.fd   = -1;
+			s.size = 0;
+		}
+	};
+
+	try {
+		// wait for everything that was queued, including what wasn't submitted yet
+		while( pending != 0 ) {
+			submit_and_wait();
+			unsigned head = *_cq_head;
+			while( head != __atomic_load_n( _cq_tail, __ATOMIC_ACQUIRE ) ) {
+				const auto cqe = static_cast<const io_uring_cqe*>( _cqes )[head & _cq_mask];
+				head++;
+				pending--;
+				if( cqe.user_data != close_tag && cqe.res >= 0 ) {
+					auto& s = _slots[static_cast<std::uint32_t>( cqe.user_data )];
+					if( s.fd < 0 ) { // an open completed, the file has to be closed
+						s.fd = cqe.res;
+					}
+				}
+			}
+			__atomic_store_n( _cq_head, head, __ATOMIC_RELEASE );
+		}
+	} catch( ... ) {
+		// the ring is in an unknown state, so this reader falls back to synchronous reads from now on
+		close_files();
+		teardown();
+		return;
+	}
+	close_files();
+}
+
+#else
+
+UringReader::UringReader( unsigned ) {}
+UringReader::~UringReader() = default;
+
+bool UringReader::is_supported()
+{
+	return false;
+}
+
+bool UringReader::setup( unsigned )
+{
+	return false;
+}
+void UringReader::teardown() {}
+
+void UringReader::read_files_async( const std::vector<std::filesystem::path>& files, const Callback& on_read )
+{
+	read_files_sync( files, on_read );
+}
+
+void UringReader::abort_batch( std::size_t ) noexcept {}
+
+#endif
+
+} // namespace mdev
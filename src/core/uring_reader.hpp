@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mdev {
+
+/**
+ * Reads a batch of files with many opens and reads in flight at the same time (io_uring based - linux only).
+ *
+ * This mainly pays off on a cold page cache / network file systems, where every blocking open and read
+ * costs a full round trip. If io_uring isn't available (old kernel, other OS, disabled by seccomp ...),
+ * read_files() falls back to reading the files one by one.
+ * An instance must only be used by one thread at a time.
+ */
+class UringReader {
+public:
+	// content is only valid during the call. Files that can't be read result in an empty content
+	using Callback = std::function<void( std::size_t index, std::string_view content )>;
+
+	explicit UringReader( unsigned queue_depth = 128 );
+	UringReader( const UringReader& ) = delete;
+	UringReader& operator=( const UringReader& ) = delete;
+	~UringReader();
+
+	static bool is_supported();
+
+	// false if the synchronous fallback is used
+	bool is_async() const { return _ring_fd >= 0; }
+
+	// on_read is called exactly once for every file, in the order the reads complete.
+	// If it throws, the remaining files are skipped and the reader can be used for the next batch
+	void read_files( const std::vector<std::filesystem::path>& files, const Callback& on_read );
+
+private:
+	struct Slot {
+		std::size_t       file_index = 0;
+		std::string       path;
+		int               fd = -1;
+		std::vector<char> buffer;
+		std::size_t       size = 0;
+	};
+
+	bool setup( unsigned queue_depth );
+	void teardown();
+
+	void read_files_sync( const std::vector<std::filesystem::path>& files, const Callback& on_read );
+	void read_files_async( const std::vector<std::filesystem::path>& files, const Callback& on_read );
+
+	void push_open( std::uint32_t slot );
+	void push_read( std::uint32_t slot );
+	void push_close( int fd );
+	void submit_and_wait();
+
+	// Waits for the requests of a batch that was interrupted by an exception and closes its files
+	void abort_batch( std::size_t pending ) noexcept;
+
+	int _ring_fd = -1;
+
+	// ring buffers shared with the kernel
+	void*       _sq_ring      = nullptr;
+	std::size_t _sq_ring_size = 0;
+	void*       _cq_ring      = nullptr;
+	std::size_t _cq_ring_size = 0;
+	void*       _sqes         = nullptr;
+	std::size_t _sqes_size    = 0;
+
+	unsigned* _sq_head  = nullptr;
+	unsigned* _sq_tail  = nullptr;
+	unsigned  _sq_mask  = 0;
+	unsigned* _sq_array = nullptr;
+	unsigned* _cq_head  = nullptr;
+	unsigned* _cq_tail  = nullptr;
+	unsigned  _cq_mask  = 0;
+	void*     _cqes     = nullptr;
+
+	unsigned _local_tail = 0;
+
+	std::vector<Slot> _slots;
+};
+
+} // namespace mdev
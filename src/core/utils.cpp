@@ -0,0 +1,99 @@
+#include "utils.hpp"
+
+#include <cstring>
+
+namespace mdev {
+
+namespace {
+
+constexpr std::uint64_t prime1 = 11400714785074694791ull;
+constexpr std::uint64_t prime2 = 14029467366897019727ull;
+constexpr std::uint64_t prime3 = 1609587929392839161ull;
+constexpr std::uint64_t prime4 = 9650029242287828579ull;
+constexpr std::uint64_t prime5 = 2870177450012600261ull;
+
+std::uint64_t rotl( std::uint64_t x, int r )
+{
+	return ( x << r ) | ( x >> ( 64 - r ) );
+}
+
+// little endian loads (memcpy keeps it free of alignment issues, the compiler turns it into a plain load)
+std::uint64_t read64( const char* p )
+{
+	std::uint64_t v;
+	std::memcpy( &v, p, sizeof( v ) );
+	return v;
+}
+
+std::uint32_t read32( const char* p )
+{
+	std::uint32_t v;
+	std::memcpy( &v, p, sizeof( v ) );
+	return v;
+}
+
+std::uint64_t xxh_round( std::uint64_t acc, std::uint64_t input )
+{
+	acc += input * prime2;
+	acc = rotl( acc, 31 );
+	return acc * prime1;
+}
+
+std::uint64_t merge_round( std::uint64_t acc, std::uint64_t val )
+{
+	acc ^= xxh_round( 0, val );
+	return acc * prime1 + prime4;
+}
+
+} // namespace
+
+std::uint64_t hash64( std::string_view data, std::uint64_t seed )
+{
+	const char*       p   = data.data();
+	const char* const end = p + data.size();
+
+	std::uint64_t h;
+	if( data.size() >= 32 ) {
+		std::uint64_t v1 = seed + prime1 + prime2;
+		std::uint64_t v2 = seed + prime2;
+		std::uint64_t v3 = seed;
+		std::uint64_t v4 = seed - prime1;
+		for( ; end - p >= 32; p += 32 ) {
+			v1 = xxh_round( v1, read64( p ) );
+			v2 = xxh_round( v2, read64( p + 8 ) );
+			v3 = xxh_round( v3, read64( p + 16 ) );
+			v4 = xxh_round( v4, read64( p + 24 ) );
+		}
+		h = rotl( v1, 1 ) + rotl( v2, 7 ) + rotl( v3, 12 ) + rotl( v4, 18 );
+		h = merge_round( h, v1 );
+		h = merge_round( h, v2 );
+		h = merge_round( h, v3 );
+		h = merge_round( h, v4 );
+	} else {
+		h = seed + prime5;
+	}
+	h += data.size();
+
+	for( ; end - p >= 8; p += 8 ) {
+		h ^= xxh_round( 0, read64( p ) );
+		h = rotl( h, 27 ) * prime1 + prime4;
+	}
+	if( end - p >= 4 ) {
+		h ^= std::uint64_t( read32( p ) ) * prime1;
+		h = rotl( h, 23 ) * prime2 + prime3;
+		p += 4;
+	}
+	for( ; p < end; ++p ) {
+		h ^= std::uint64_t( static_cast<unsigned char>( *p ) ) * prime5;
+		h = rotl( h, 11 ) * prime1;
+	}
+
+	h ^= h >> 33;
+	h *= prime2;
+	h ^= h >> 29;
+	h *= prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+} // namespace mdev
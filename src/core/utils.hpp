@@ -1,8 +1,11 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 
 namespace mdev {
 
@@ -48,7 +51,14 @@ struct span {
 		, _size( r.size() )
 	{
 	}
+	span( T* start, std::size_t size )
+		: _start( start )
+		, _size( size )
+	{
+	}
 	std::size_t size() const { return _size; }
+	bool        empty() const { return _size == 0; }
+	T&          operator[]( std::size_t i ) const { return _start[i]; }
 
 	T* begin() const { return _start; }
 	T* end() const { return _start + _size; }
@@ -64,6 +74,31 @@ std::vector<T> to_vector( C container )
 	return std::vector<T>( std::make_move_iterator( container.begin() ), std::make_move_iterator( container.end() ) );
 }
 
+// Adds the time between construction and destruction to target (if there is one)
+class ScopedTimer {
+public:
+	explicit ScopedTimer( std::chrono::nanoseconds* target )
+		: _target( target )
+		, _start( std::chrono::steady_clock::now() )
+	{
+	}
+	ScopedTimer( const ScopedTimer& ) = delete;
+	ScopedTimer& operator=( const ScopedTimer& ) = delete;
+	~ScopedTimer()
+	{
+		if( _target ) {
+			*_target += std::chrono::steady_clock::now() - _start;
+		}
+	}
+
+private:
+	std::chrono::nanoseconds*             _target;
+	std::chrono::steady_clock::time_point _start;
+};
+
+// Fast non-cryptographic hash (xxHash64 algorithm), stable across runs
+std::uint64_t hash64( std::string_view data, std::uint64_t seed = 0 );
+
 using String_t = std::string;
 template<class... ARGS>
 String_t str_concat( const ARGS& ... args)
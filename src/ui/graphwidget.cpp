@@ -157,6 +157,10 @@ void GraphWidget::keyPressEvent( QKeyEvent* event )
 			emit( cycle_dedection_requested() );
 			break;
 		}
+		case Qt::Key_W: {
+			emit( watch_mode_toggle_requested() );
+			break;
+		}
 		case Qt::Key_P: {
 
 			QPainter pngPainter;
@@ -32,6 +32,7 @@ signals:
 	void reprint_stats_requested();
 	void reset_requested();
 	void cycle_dedection_requested();
+	void watch_mode_toggle_requested();
 
 protected:
 	void keyPressEvent( QKeyEvent* event ) override;
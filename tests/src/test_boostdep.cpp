@@ -0,0 +1,1022 @@
+#include <core/bitset.hpp>
+#include <core/boostdep.hpp>
+#include <core/dependency_graph.hpp>
+#include <core/content_dedup.hpp>
+#include <core/directory_walker.hpp>
+#include <core/file_classifier.hpp>
+#include <core/file_graph.hpp>
+#include <core/file_index.hpp>
+#include <core/git_repository.hpp>
+#include <core/scan_cache.hpp>
+#include <core/snapshot.hpp>
+#include <core/stats_report.hpp>
+#include <core/tree_watcher.hpp>
+#include <core/uring_reader.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace mdev;
+
+namespace {
+
+void write_file( const fs::path& file, const std::string& content )
+{
+	fs::create_directories( file.parent_path() );
+	std::ofstream( file, std::ios::binary ) << content;
+}
+
+// Creates a minimal boost tree with two modules "a" and "b" below the temp directory
+fs::path make_test_tree( const std::string& name )
+{
+	const auto root = fs::temp_directory_path() / ( "bdg_test_tree_" + name );
+	fs::remove_all( root );
+
+	write_file( root / "libs/a/include/boost/a.hpp",
+				"#pragma once\n"
+				"#include <boost/b/b.hpp>\n"
+				"  #  include \"boost/a/detail/impl.hpp\"\r\n"
+				"#include <vector>\n"
+				"// #include <boost/not/included.hpp>\n"
+				"#include <boost/b/last_line_without_newline.hpp>" );
+	write_file( root / "libs/a/include/boost/a/detail/impl.hpp", "\t#include <boost/b/b.hpp>\n" );
+	write_file( root / "libs/a/include/boost/a/empty.hpp", "" );
+	write_file( root / "libs/a/src/a.cpp", "#include <boost/a.hpp>\n" );
+	write_file( root / "libs/b/include/boost/b/b.hpp", "#pragma once\n" );
+	write_file( root / "libs/b/include/boost/b/last_line_without_newline.hpp", "int i;" );
+
+	return root;
+}
+
+auto sorted_by_name( std::vector<boostdep::FileInfo> files )
+{
+	std::sort( files.begin(), files.end(), []( const auto& l, const auto& r ) { return l.name < r.name; } );
+	return files;
+}
+
+const boostdep::FileInfo& find_file( const std::vector<boostdep::FileInfo>& files, std::string_view name )
+{
+	auto it = std::find_if( files.begin(), files.end(), [&]( const auto& f ) { return f.name == name; } );
+	REQUIRE( it != files.end() );
+	return *it;
+}
+
+} // namespace
+
+TEST_CASE( "scan_read_methods_agree", "[boost_dep_graph_tests]" )
+{
+	const auto root = make_test_tree( "read_methods" );
+
+	// bigger than the initial read buffer of the io_uring reader
+	write_file( root / "libs/b/include/boost/b/big.hpp",
+				std::string( 100'000, '/' ) + "\n#include <boost/a.hpp>\n" + std::string( 50'000, ' ' ) );
+
+	boostdep::ScanOptions options;
+	options.read_method = boostdep::ReadMethod::Stream;
+	const auto stream   = sorted_by_name( boostdep::scan_all_boost_modules( root, options ) );
+	options.read_method = boostdep::ReadMethod::MemoryMap;
+	const auto mapped   = sorted_by_name( boostdep::scan_all_boost_modules( root, options ) );
+	options.read_method = boostdep::ReadMethod::IoUring;
+	const auto uring    = sorted_by_name( boostdep::scan_all_boost_modules( root, options ) );
+
+	REQUIRE( stream.size() == 7 );
+	REQUIRE( stream.size() == mapped.size() );
+	REQUIRE( stream.size() == uring.size() );
+	for( std::size_t i = 0; i < stream.size(); ++i ) {
+		CHECK( stream[i].name == mapped[i].name );
+		CHECK( stream[i].module_name == mapped[i].module_name );
+		CHECK( stream[i].included_files == mapped[i].included_files );
+		CHECK( uring[i].name == mapped[i].name );
+		CHECK( uring[i].included_files == mapped[i].included_files );
+	}
+	CHECK( find_file( uring, "boost/b/big.hpp" ).included_files == std::vector<String_t>{"boost/a.hpp"} );
+
+	const std::vector<String_t> ref{
+		"boost/b/b.hpp", "boost/a/detail/impl.hpp", "boost/b/last_line_without_newline.hpp"};
+	CHECK( find_file( mapped, "boost/a.hpp" ).included_files == ref );
+	CHECK( find_file( mapped, "a/src/a.cpp" ).included_files == std::vector<String_t>{"boost/a.hpp"} );
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "uring_reader_recovers_from_throwing_callback", "[boost_dep_graph_tests]" )
+{
+	const auto root = fs::temp_directory_path() / "bdg_test_uring_reader";
+	fs::remove_all( root );
+
+	std::vector<fs::path>    files;
+	std::vector<std::string> contents;
+	for( int i = 0; i < 200; ++i ) {
+		// some of them are bigger than the initial read buffer
+		contents.push_back( std::string( i % 7 == 0 ? 40'000 + i : i, static_cast<char>( 'a' + i % 26 ) ) );
+		files.push_back( root / ( std::to_string( i ) + ".hpp" ) );
+		write_file( files.back(), contents.back() );
+	}
+	files.push_back( root / "does_not_exist.hpp" );
+	contents.emplace_back();
+
+	const auto open_fds = [] {
+		std::error_code ec;
+		const auto      n = std::distance( fs::directory_iterator( "/proc/self/fd", ec ), fs::directory_iterator{} );
+		return ec ? 0 : n;
+	};
+	UringReader reader( 8 );
+	const auto  fds_before = open_fds(); // the ring itself has one
+
+	std::size_t calls = 0;
+	CHECK_THROWS_AS( reader.read_files( files,
+										[&]( std::size_t, std::string_view ) {
+											if( ++calls == 50 ) {
+												throw std::runtime_error( "parse error" );
+											}
+										} ),
+					 std::runtime_error );
+	CHECK( open_fds() == fds_before );
+
+	// the next batch must not see anything of the aborted one
+	std::vector<int> seen( files.size(), 0 );
+	bool             all_equal = true;
+	reader.read_files( files, [&]( std::size_t i, std::string_view content ) {
+		seen[i]++;
+		all_equal &= content == contents[i];
+	} );
+	CHECK( all_equal );
+	CHECK( std::count( seen.begin(), seen.end(), 1 ) == static_cast<std::ptrdiff_t>( files.size() ) );
+	CHECK( open_fds() == fds_before );
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "pipeline_scan_matches_work_stealing_scan", "[boost_dep_graph_tests]" )
+{
+	const auto root = make_test_tree( "pipeline" );
+	for( int i = 0; i < 100; ++i ) {
+		write_file( root / ( "libs/b/include/boost/b/many/f" + std::to_string( i ) + ".hpp" ),
+					"#include <boost/a.hpp>\n" );
+	}
+
+	boostdep::ScanOptions options;
+	const auto            ref = sorted_by_name( boostdep::scan_all_boost_modules( root, options ) );
+
+	// a tiny queue, so producers and consumers actually have to wait for each other
+	options.strategy                = boostdep::ScanStrategy::Pipeline;
+	options.pipeline.queue_capacity = 4;
+	options.pipeline.reader_threads = 3;
+	options.pipeline.parser_threads = 2;
+
+	boostdep::ScanStats stats;
+	const auto          files = sorted_by_name( boostdep::scan_all_boost_modules( root, options, &stats ) );
+
+	REQUIRE( files.size() == ref.size() );
+	for( std::size_t i = 0; i < files.size(); ++i ) {
+		CHECK( files[i].name == ref[i].name );
+		CHECK( files[i].module_name == ref[i].module_name );
+		CHECK( files[i].category == ref[i].category );
+		CHECK( files[i].included_files == ref[i].included_files );
+	}
+
+	REQUIRE( stats.stages.size() == 3 );
+	CHECK( stats.workers.empty() );
+	CHECK( stats.stages[1].threads == 3 );
+	CHECK( stats.stages[2].threads == 2 );
+	for( const auto& stage : stats.stages ) {
+		CHECK( stage.items == files.size() );
+	}
+	CHECK( stats.stages[1].input.capacity == 4 );
+	CHECK( stats.stages[1].input.max_depth <= 4 );
+	CHECK( stats.stages[2].input.max_depth > 0 );
+
+	// the interned variant goes through the same pipeline
+	const auto interned = boostdep::to_file_infos( boostdep::scan_all_boost_modules_interned( root, options ) );
+	CHECK( sorted_by_name( interned ).size() == ref.size() );
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "directory_walker_matches_std_filesystem", "[boost_dep_graph_tests]" )
+{
+	const auto root = make_test_tree( "walker" );
+	for( int i = 0; i < 2000; ++i ) { // more entries than fit into one getdents64 call
+		write_file( root / "libs/b/many" / ( "a_long_file_name_" + std::to_string( i ) + ".hpp" ), "" );
+	}
+	fs::create_directories( root / "libs/empty" );
+	fs::create_symlink( root / "libs/a/src/a.cpp", root / "libs/b/link_to_file.cpp" );
+	fs::create_directory_symlink( root / "libs/a", root / "libs/b/link_to_dir" );
+	fs::create_symlink( root / "does_not_exist", root / "libs/b/dangling" );
+
+	std::vector<std::string> ref;
+	for( const auto& entry : fs::recursive_directory_iterator( root / "libs" ) ) {
+		if( entry.is_regular_file() ) {
+			ref.push_back( entry.path().generic_string() );
+		}
+	}
+
+	DirectoryWalker          walker;
+	std::vector<std::string> files;
+	walker.walk( root / "libs", [&]( std::string_view path ) { files.emplace_back( path ); } );
+
+	std::sort( ref.begin(), ref.end() );
+	std::sort( files.begin(), files.end() );
+	CHECK( files.size() == 2007 );
+	CHECK( files == ref );
+
+	std::vector<std::string> listed_files, listed_dirs;
+	walker.list(
+		root / "libs/b",
+		[&]( std::string_view path ) { listed_files.emplace_back( path ); },
+		[&]( std::string_view path ) { listed_dirs.emplace_back( path ); } );
+	std::sort( listed_dirs.begin(), listed_dirs.end() );
+	CHECK( listed_files == std::vector<std::string>{( root / "libs/b/link_to_file.cpp" ).generic_string()} );
+	CHECK( listed_dirs
+		   == std::vector<std::string>{( root / "libs/b/include" ).generic_string(),
+									   ( root / "libs/b/many" ).generic_string()} );
+
+	CHECK_THROWS_AS( walker.walk( root / "does_not_exist", []( std::string_view ) {} ), fs::filesystem_error );
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "classifier_skips_non_source_files", "[boost_dep_graph_tests]" )
+{
+	const auto root = make_test_tree( "classifier" );
+	write_file( root / "libs/a/test/test.cpp", "#include <boost/a.hpp>\n" );
+	write_file( root / "libs/a/test/Jamfile.v2", "#include <boost/jam.hpp>\n" );
+	write_file( root / "libs/a/test/data.TXT", "#include <boost/data.hpp>\n" );
+	write_file( root / "libs/a/test/logo", std::string( "\x89PNG\r\n#include <boost/png.hpp>\n" ) );
+	write_file( root / "libs/a/test/blob", std::string( "#include <boost/blob.hpp>\n\0\1", 29 ) );
+	write_file( root / "libs/a/src/config_header", "#include <boost/b/b.hpp>\n" ); // unknown type, but text
+
+	boostdep::FileClassifier classifier;
+	CHECK( classifier.classify( "a/b.hpp" ) == boostdep::FileClass::Source );
+	CHECK( classifier.classify( "a/Jamfile" ) == boostdep::FileClass::Skipped );
+	CHECK( classifier.classify( "a/image.PNG" ) == boostdep::FileClass::Skipped );
+	CHECK( classifier.classify( "a/cstdio" ) == boostdep::FileClass::Unknown );
+
+	boostdep::ScanOptions options;
+	options.track_tests = boostdep::TrackTests::Yes;
+	const auto all      = boostdep::scan_all_boost_modules( root, options );
+	options.classifier  = &classifier;
+
+	// unknown files are sniffed by whatever reads their content
+	using boostdep::ReadMethod;
+	using boostdep::ScanStrategy;
+	const std::pair<ScanStrategy, ReadMethod> configs[] = {{ScanStrategy::WorkStealing, ReadMethod::Stream},
+														   {ScanStrategy::WorkStealing, ReadMethod::MemoryMap},
+														   {ScanStrategy::WorkStealing, ReadMethod::IoUring},
+														   {ScanStrategy::Pipeline, ReadMethod::MemoryMap}};
+	for( const auto& [strategy, read_method] : configs ) {
+		options.strategy    = strategy;
+		options.read_method = read_method;
+		boostdep::ScanStats stats;
+		const auto          files = sorted_by_name( boostdep::scan_all_boost_modules( root, options, &stats ) );
+
+		CHECK( stats.skipped_files == 4 );
+		REQUIRE( files.size() == all.size() - 4 );
+		CHECK( find_file( files, "a/test/test.cpp" ).included_files == std::vector<String_t>{"boost/a.hpp"} );
+		CHECK( find_file( files, "a/src/config_header" ).included_files == std::vector<String_t>{"boost/b/b.hpp"} );
+		for( const auto& f : files ) {
+			CHECK( f.name != "a/test/Jamfile.v2" );
+			CHECK( f.name != "a/test/data.TXT" );
+			CHECK( f.name != "a/test/logo" );
+			CHECK( f.name != "a/test/blob" );
+		}
+	}
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "scan_and_analysis_stats_are_filled", "[boost_dep_graph_tests]" )
+{
+	const auto root = make_test_tree( "stats" );
+	write_file( root / "libs/b/include/boost/b/broken.hpp", "#include <boost/b/missing.hpp>\n" );
+
+	boostdep::ScanOptions options;
+	for( auto strategy : {boostdep::ScanStrategy::WorkStealing, boostdep::ScanStrategy::Pipeline} ) {
+		options.strategy = strategy;
+		boostdep::ScanStats stats;
+		const auto          files = boostdep::scan_all_boost_modules( root, options, &stats );
+
+		std::size_t includes = 0;
+		for( const auto& f : files ) {
+			includes += f.included_files.size();
+		}
+
+		CHECK( stats.files == files.size() );
+		CHECK( stats.include_hits == includes );
+		CHECK( stats.include_candidates >= stats.include_hits );
+		CHECK( stats.lines_inspected >= stats.include_candidates );
+		CHECK( stats.bytes_read > 0 );
+		CHECK( stats.total.count() > 0 );
+
+		std::size_t module_files = 0;
+		for( const auto& m : stats.modules ) {
+			module_files += m.files;
+		}
+		CHECK( module_files == files.size() );
+		CHECK( stats.modules.size() == 2 );
+
+		boostdep::AnalysisStats analysis;
+		const auto              deps = boostdep::build_module_dependency_map( files, &analysis );
+		CHECK( analysis.files == files.size() );
+		CHECK( analysis.nodes == deps.size() );
+		CHECK( analysis.unresolved_includes == 1 );
+		CHECK( analysis.resolved_includes + analysis.unresolved_includes == includes );
+
+		const auto scan_json     = boostdep::to_json( stats );
+		const auto analysis_json = boostdep::to_json( analysis );
+		CHECK( scan_json.find( "\"include_hits\":" + std::to_string( includes ) ) != std::string::npos );
+		CHECK( scan_json.find( "\"name\":\"a\"" ) != std::string::npos );
+		CHECK( analysis_json.find( "\"unresolved_includes\":1" ) != std::string::npos );
+		CHECK( analysis_json.find( "\"sort_ms\":" ) != std::string::npos ); // older name of index_ms
+
+		// the reports must not change the formatting of the caller's stream
+		std::ostringstream report;
+		const auto         flags     = report.flags();
+		const auto         precision = report.precision();
+		boostdep::print_stats( report, stats );
+		boostdep::print_stats( report, analysis );
+		boostdep::print_unresolved_includes( report, analysis.unresolved );
+		CHECK( report.flags() == flags );
+		CHECK( report.precision() == precision );
+	}
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "prefilter_kernels_agree", "[boost_dep_graph_tests]" )
+{
+	const std::vector<std::string> snippets{"#include <boost/config.hpp>",
+											"  #\tinclude \"boost/a/b.hpp\"",
+											"#include <vector>",
+											"x #include <boost/not_at_line_start.hpp>",
+											"#includ <boost/typo.hpp>",
+											"#include<boost/no_space.hpp>",
+											"#define FOO #",
+											"##",
+											"int i = 0;",
+											"\r",
+											" ",
+											"\n",
+											"\n\n"};
+
+	std::mt19937                               gen{0};
+	std::uniform_int_distribution<std::size_t> dist( 0, snippets.size() - 1 );
+
+	for( int i = 0; i < 200; ++i ) {
+		std::string content;
+		while( content.size() < static_cast<std::size_t>( i ) * 10 ) {
+			content += snippets[dist( gen )];
+			content += '\n';
+		}
+		// make sure we also hit the end of the buffer in the middle of a directive
+		content.resize( content.size() - i % 7 );
+
+		const auto ref = boostdep::parse_included_boost_headers( content, boostdep::PrefilterKernel::None );
+		for( auto kernel : {boostdep::PrefilterKernel::Scalar,
+							boostdep::PrefilterKernel::SSE2,
+							boostdep::PrefilterKernel::AVX2,
+							boostdep::PrefilterKernel::Auto} ) {
+			CHECK( boostdep::parse_included_boost_headers( content, kernel ) == ref );
+		}
+	}
+}
+
+TEST_CASE( "include_matcher_supports_multiple_roots", "[boost_dep_graph_tests]" )
+{
+	const boostdep::IncludeMatcher matcher( {"boost/", "corp/", "corp_net/", "q/"} );
+	CHECK( matcher.matches( "boost/a.hpp" ) );
+	CHECK( matcher.matches( "corp/x/y.h" ) );
+	CHECK( matcher.matches( "corp_net/socket.h" ) );
+	CHECK( matcher.matches( "q/a.h" ) );
+	CHECK( !matcher.matches( "corp" ) );
+	CHECK( !matcher.matches( "corp_/x.h" ) );
+	CHECK( !matcher.matches( "boostx/a.hpp" ) );
+	CHECK( !matcher.matches( "vector" ) );
+	CHECK( !matcher.matches( "" ) );
+	CHECK( matcher.min_include_size() == 2 + 7 );
+	CHECK_THROWS( boostdep::IncludeMatcher( {} ) );
+
+	const std::string content = "#include <boost/a.hpp>\n"
+								"#include \"corp/util/strings.h\"\n"
+								"  #  include <corp_net/socket.h> // comment\n"
+								"#include <q/abc.h>\n"
+								"#include <corporate/not_a_root.h>\n"
+								"#include <vector>\n";
+	const std::vector<String_t> expected{"boost/a.hpp", "corp/util/strings.h", "corp_net/socket.h", "q/abc.h"};
+	for( auto kernel : {boostdep::PrefilterKernel::None,
+						boostdep::PrefilterKernel::Scalar,
+						boostdep::PrefilterKernel::SSE2,
+						boostdep::PrefilterKernel::AVX2} ) {
+		CHECK( boostdep::parse_included_boost_headers( content, kernel, matcher ) == expected );
+		CHECK( boostdep::parse_included_boost_headers( content, kernel )
+			   == std::vector<String_t>{"boost/a.hpp"} );
+	}
+
+	const auto root = make_test_tree( "include_roots" );
+	write_file( root / "libs/c/include/corp/c.hpp", "#include <corp/detail/c_impl.hpp>\n#include <boost/a.hpp>\n" );
+	write_file( root / "libs/c/include/corp/detail/c_impl.hpp", "" );
+
+	boostdep::ScanOptions options;
+	options.include_matcher = &matcher;
+	for( auto method : {boostdep::ReadMethod::Stream, boostdep::ReadMethod::MemoryMap} ) {
+		options.read_method = method;
+		const auto files    = boostdep::scan_all_boost_modules( root, options );
+		CHECK( find_file( files, "corp/c.hpp" ).included_files
+			   == std::vector<String_t>{"corp/detail/c_impl.hpp", "boost/a.hpp"} );
+
+		const auto deps = boostdep::to_dependency_info( boostdep::build_module_dependency_map( files ) );
+		CHECK( deps.at( "c" ) == std::vector<String_t>{"a"} );
+	}
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "scan_cache_only_rescans_changed_files", "[boost_dep_graph_tests]" )
+{
+	const auto root       = make_test_tree( "scan_cache" );
+	const auto cache_file = root / "scan.cache";
+
+	boostdep::ScanCache   cache;
+	boostdep::ScanOptions options;
+	options.cache = &cache;
+
+	const auto initial = sorted_by_name( boostdep::scan_all_boost_modules( root, options ) );
+	CHECK( cache.hits() == 0 );
+	CHECK( cache.misses() == initial.size() );
+	REQUIRE( cache.save( cache_file ) );
+
+	write_file( root / "libs/a/include/boost/a/empty.hpp", "#include <boost/b/b.hpp>\n" );
+
+	boostdep::ScanCache loaded;
+	REQUIRE( loaded.load( cache_file ) );
+	CHECK( loaded.size() == initial.size() );
+
+	options.cache        = &loaded;
+	const auto rescanned = sorted_by_name( boostdep::scan_all_boost_modules( root, options ) );
+	CHECK( loaded.hits() == initial.size() - 1 );
+	CHECK( loaded.misses() == 1 );
+
+	REQUIRE( rescanned.size() == initial.size() );
+	for( std::size_t i = 0; i < initial.size(); ++i ) {
+		if( rescanned[i].name == "boost/a/empty.hpp" ) {
+			CHECK( rescanned[i].included_files == std::vector<String_t>{"boost/b/b.hpp"} );
+		} else {
+			CHECK( rescanned[i].included_files == initial[i].included_files );
+		}
+	}
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "rescan_paths_matches_full_scan", "[boost_dep_graph_tests]" )
+{
+	const auto root = make_test_tree( "rescan_paths" );
+
+	const boostdep::ScanOptions options;
+	auto                        files = boostdep::scan_all_boost_modules( root, options );
+
+	write_file( root / "libs/a/include/boost/a/empty.hpp", "#include <boost/b/b.hpp>\n" );
+	write_file( root / "libs/b/include/boost/b/new/c.hpp", "#include <boost/a.hpp>\n" );
+	fs::remove( root / "libs/a/src/a.cpp" );
+
+	const std::vector<fs::path> changed{root / "libs/a/include/boost/a/empty.hpp",
+										root / "libs/b/include/boost/b/new",
+										root / "libs/a/src/a.cpp",
+										root / "libs/not_a_module/foo.hpp"};
+
+	CHECK( boostdep::rescan_paths( files, root, changed, options ) );
+	CHECK( !boostdep::rescan_paths( files, root, {root / "libs/b/include/boost/b/b.hpp"}, options ) );
+
+	const auto full    = sorted_by_name( boostdep::scan_all_boost_modules( root, options ) );
+	const auto patched = sorted_by_name( files );
+	REQUIRE( full.size() == patched.size() );
+	for( std::size_t i = 0; i < full.size(); ++i ) {
+		CHECK( full[i].name == patched[i].name );
+		CHECK( full[i].module_name == patched[i].module_name );
+		CHECK( full[i].included_files == patched[i].included_files );
+	}
+
+	// files of a module have to stay together
+	CHECK( std::is_sorted(
+		files.begin(), files.end(), []( const auto& l, const auto& r ) { return l.module_name < r.module_name; } ) );
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "tree_watcher_reports_changes", "[boost_dep_graph_tests]" )
+{
+	if( !boostdep::TreeWatcher::is_supported() ) {
+		return;
+	}
+	const auto root = make_test_tree( "tree_watcher" );
+
+	std::mutex              mx;
+	std::condition_variable cv;
+	bool                    notified = false;
+
+	boostdep::TreeWatcher watcher;
+	REQUIRE( watcher.start( boostdep::get_scanned_directories( root, {} ), [&] {
+		std::lock_guard lg( mx );
+		notified = true;
+		cv.notify_one();
+	} ) );
+
+	write_file( root / "libs/a/include/boost/a/detail/impl.hpp", "#include <boost/a.hpp>\n" );
+
+	std::unique_lock lock( mx );
+	REQUIRE( cv.wait_for( lock, std::chrono::seconds( 5 ), [&] { return notified; } ) );
+
+	const auto changes = watcher.take_changes();
+	CHECK( !changes.overflow );
+	CHECK( std::count( changes.paths.begin(), changes.paths.end(), root / "libs/a/include/boost/a/detail/impl.hpp" )
+		   == 1 );
+
+	watcher.stop();
+	fs::remove_all( root );
+}
+
+TEST_CASE( "interned_scan_matches_plain_scan", "[boost_dep_graph_tests]" )
+{
+	const auto root = make_test_tree( "interned" );
+
+	mdev::StringPool pool;
+	CHECK( pool.intern( "boost/a.hpp" ) == pool.intern( std::string( "boost/a.hpp" ) ) );
+	CHECK( pool.view( pool.intern( "boost/b.hpp" ) ) == "boost/b.hpp" );
+	CHECK( !pool.find( "boost/c.hpp" ) );
+
+	const boostdep::ScanOptions options;
+	const auto                  files    = boostdep::scan_all_boost_modules( root, options );
+	const auto                  interned = boostdep::scan_all_boost_modules_interned( root, options, nullptr, pool );
+
+	REQUIRE( interned.size() == files.size() );
+	CHECK( interned[0].module_name == *pool.find( files[0].module_name ) );
+
+	const auto plain   = sorted_by_name( files );
+	const auto decoded = sorted_by_name( boostdep::to_file_infos( interned, pool ) );
+	for( std::size_t i = 0; i < plain.size(); ++i ) {
+		CHECK( plain[i].name == decoded[i].name );
+		CHECK( plain[i].module_name == decoded[i].module_name );
+		CHECK( plain[i].category == decoded[i].category );
+		CHECK( plain[i].included_files == decoded[i].included_files );
+	}
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "file_graph_matches_file_infos", "[boost_dep_graph_tests]" )
+{
+	const auto root  = make_test_tree( "file_graph" );
+	const auto files = boostdep::scan_all_boost_modules( root, boostdep::ScanOptions{} );
+	const auto graph = boostdep::make_file_graph( files );
+
+	REQUIRE( graph.file_count() == files.size() );
+	CHECK( boostdep::build_module_dependency_map( graph ) == boostdep::build_module_dependency_map( files ) );
+	for( const auto* module : {"a", "b"} ) {
+		CHECK( boostdep::build_filtered_module_dependency_map( graph, module )
+			   == boostdep::build_filtered_module_dependency_map( files, module ) );
+		CHECK( boostdep::build_filtered_file_dependency_map( graph, module )
+			   == boostdep::build_filtered_file_dependency_map( files, module ) );
+	}
+
+	boostdep::AnalysisStats graph_stats;
+	boostdep::AnalysisStats file_stats;
+	boostdep::build_filtered_module_dependency_map( graph, "a", &graph_stats );
+	boostdep::build_filtered_module_dependency_map( files, "a", &file_stats );
+	CHECK( graph_stats.files == file_stats.files );
+	CHECK( graph_stats.nodes == file_stats.nodes );
+	CHECK( graph_stats.resolved_includes == file_stats.resolved_includes );
+	CHECK( graph_stats.unresolved_includes == file_stats.unresolved_includes );
+
+	const auto graph_file = root / "graph.bin";
+	REQUIRE( graph.save( graph_file ) );
+	boostdep::FileGraph loaded;
+	REQUIRE( loaded.load( graph_file ) );
+	CHECK( loaded.edges == graph.edges );
+	CHECK( boostdep::to_file_infos( loaded ).size() == files.size() );
+	CHECK( boostdep::to_file_infos( loaded )[0].included_files == files[0].included_files );
+
+	// unknown categories must be rejected
+	auto corrupt          = graph;
+	corrupt.categories[0] = static_cast<boostdep::FileCategory>( 7 );
+	CHECK( !corrupt.is_consistent() );
+	REQUIRE( corrupt.save( graph_file ) );
+	CHECK( !loaded.load( graph_file ) );
+	REQUIRE( graph.save( graph_file ) );
+
+	// truncated files must be rejected
+	const auto size = fs::file_size( graph_file );
+	fs::resize_file( graph_file, size - 1 );
+	CHECK( !loaded.load( graph_file ) );
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "dynamic_bitset", "[boost_dep_graph_tests]" )
+{
+	DynamicBitset bits( 130 );
+	CHECK( bits.count() == 0 );
+	CHECK( !bits.test_and_set( 0 ) );
+	CHECK( bits.test_and_set( 0 ) );
+	bits.set( 64 );
+	bits.set( 129 );
+	CHECK( bits.test( 64 ) );
+	CHECK( !bits.test( 63 ) );
+	CHECK( bits.count() == 3 );
+
+	std::vector<std::size_t> set_bits;
+	bits.for_each( [&]( std::size_t i ) { set_bits.push_back( i ); } );
+	CHECK( set_bits == std::vector<std::size_t>{0, 64, 129} );
+
+	DynamicBitset other( 130 );
+	other.set( 1 );
+	CHECK( other.merge( bits ) );
+	CHECK( !other.merge( bits ) );
+	CHECK( other.count() == 4 );
+	CHECK( other != bits );
+}
+
+TEST_CASE( "file_index_finds_files", "[boost_dep_graph_tests]" )
+{
+	std::vector<boostdep::FileInfo> files;
+	for( int i = 0; i < 1000; ++i ) {
+		files.push_back( {"boost/file_" + std::to_string( i ) + ".hpp", {}, "m", boostdep::FileCategory::Header} );
+	}
+	files.push_back( {"boost/file_7.hpp", {}, "duplicate", boostdep::FileCategory::Header} );
+
+	const boostdep::FileIndex index( files );
+	for( std::size_t i = 0; i < 1000; ++i ) {
+		CHECK( index.find( files[i].name ) == i );
+	}
+	CHECK( index.find( "boost/file_1000.hpp" ) == boostdep::FileIndex::npos );
+	CHECK( index.find( "" ) == boostdep::FileIndex::npos );
+	CHECK( boostdep::FileIndex().find( "boost/file_1.hpp" ) == boostdep::FileIndex::npos );
+	CHECK( boostdep::FileIndex().files().empty() );
+	static_assert( !std::is_constructible_v<boostdep::FileIndex, std::vector<boostdep::FileInfo>&&> );
+
+	const auto root    = make_test_tree( "file_index" );
+	const auto scanned = boostdep::scan_all_boost_modules( root, boostdep::ScanOptions{} );
+
+	const boostdep::FileIndex scan_index( scanned );
+	CHECK( boostdep::build_module_dependency_map( scan_index ) == boostdep::build_module_dependency_map( scanned ) );
+	for( const auto* module : {"a", "b"} ) {
+		CHECK( boostdep::build_filtered_module_dependency_map( scan_index, module )
+			   == boostdep::build_filtered_module_dependency_map( scanned, module ) );
+		CHECK( boostdep::build_filtered_file_dependency_map( scan_index, module )
+			   == boostdep::build_filtered_file_dependency_map( scanned, module ) );
+	}
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "filtered_maps_start_at_the_files_of_the_root_module", "[boost_dep_graph_tests]" )
+{
+	// includes of boost/config.hpp refer to the first one, but b's own copy is still part of b
+	const std::vector<boostdep::FileInfo> files{
+		{"boost/config.hpp", {"boost/a_only.hpp"}, "a", boostdep::FileCategory::Header},
+		{"boost/a_only.hpp", {}, "a", boostdep::FileCategory::Header},
+		{"boost/config.hpp", {"boost/b_only.hpp"}, "b", boostdep::FileCategory::Header},
+		{"boost/b_only.hpp", {}, "b", boostdep::FileCategory::Header},
+	};
+	const boostdep::FileIndex index( files );
+	const auto                graph = boostdep::make_file_graph( files );
+
+	const auto modules = boostdep::build_filtered_module_dependency_map( files, "b" );
+	CHECK( modules.find( "a" ) == boostdep::DependencyGraph::npos );
+	CHECK( modules.find( "b" ) != boostdep::DependencyGraph::npos );
+	CHECK( modules == boostdep::build_filtered_module_dependency_map( index, "b" ) );
+	CHECK( modules == boostdep::build_filtered_module_dependency_map( graph, "b" ) );
+
+	const auto file_map = boostdep::build_filtered_file_dependency_map( files, "b" );
+	CHECK( file_map.find( "boost/b_only.hpp" ) != boostdep::DependencyGraph::npos );
+	CHECK( file_map.find( "boost/a_only.hpp" ) == boostdep::DependencyGraph::npos );
+	CHECK( file_map == boostdep::build_filtered_file_dependency_map( index, "b" ) );
+	CHECK( file_map == boostdep::build_filtered_file_dependency_map( graph, "b" ) );
+}
+
+TEST_CASE( "snapshot_roundtrip", "[boost_dep_graph_tests]" )
+{
+	const auto root  = make_test_tree( "snapshot" );
+	const auto files = boostdep::scan_all_boost_modules( root, boostdep::ScanOptions{} );
+
+	boostdep::ScanSnapshot snapshot;
+	snapshot.boost_root = root;
+	snapshot.files      = boostdep::make_file_graph( files );
+	snapshot.has_cmake  = {{"a", true}, {"b", false}, {"numeric~conversion", true}};
+
+	const auto snapshot_file = root / "snapshot.bin";
+	REQUIRE( snapshot.save( snapshot_file ) );
+
+	boostdep::ScanSnapshot loaded;
+	REQUIRE( loaded.load( snapshot_file ) );
+	CHECK( loaded.boost_root == root.generic_string() );
+	CHECK( loaded.has_cmake == snapshot.has_cmake );
+	CHECK( loaded.files.string_data == snapshot.files.string_data );
+	CHECK( loaded.files.names == snapshot.files.names );
+	CHECK( loaded.files.edges == snapshot.files.edges );
+	CHECK( boostdep::build_module_dependency_map( loaded.files ) == boostdep::build_module_dependency_map( files ) );
+
+	// the graph is stored in the same (aligned) layout FileGraph::save uses, at the end of the snapshot
+	std::ostringstream arrays;
+	snapshot.files.write_arrays( arrays );
+	const auto graph_data = arrays.str();
+	CHECK( graph_data.size() % 8 == 0 );
+
+	std::ifstream     in( snapshot_file, std::ios::binary );
+	const std::string snapshot_data{std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>()};
+	REQUIRE( snapshot_data.size() > graph_data.size() );
+	CHECK( snapshot_data.compare( snapshot_data.size() - graph_data.size(), graph_data.size(), graph_data ) == 0 );
+
+	boostdep::FileGraph graph;
+	std::string_view    remaining = graph_data;
+	REQUIRE( graph.read_arrays( remaining ) );
+	CHECK( remaining.empty() );
+	CHECK( graph.edges == snapshot.files.edges );
+	remaining = std::string_view( graph_data ).substr( 0, graph_data.size() - 8 );
+	CHECK( !graph.read_arrays( remaining ) );
+
+	// a FileGraph file is not a snapshot
+	REQUIRE( snapshot.files.save( root / "graph.bin" ) );
+	CHECK( !loaded.load( root / "graph.bin" ) );
+	CHECK( !loaded.load( root / "does_not_exist.bin" ) );
+	CHECK( loaded.has_cmake == snapshot.has_cmake ); // unchanged
+
+	// truncated files must be rejected
+	const auto size = fs::file_size( snapshot_file );
+	fs::resize_file( snapshot_file, size - 1 );
+	CHECK( !loaded.load( snapshot_file ) );
+
+	fs::remove_all( root );
+}
+
+TEST_CASE( "batch_filtered_module_maps_match_single_queries", "[boost_dep_graph_tests]" )
+{
+	const auto check = []( const std::vector<boostdep::FileInfo>& files ) {
+		const auto graph = boostdep::make_file_graph( files );
+		const auto all   = boostdep::build_all_filtered_module_dependency_maps( graph );
+		const auto modules = boostdep::build_module_dependency_map( graph );
+		for( boostdep::DependencyGraph::NodeId n = 0; n < modules.size(); ++n ) {
+			const auto module = modules.name( n );
+			REQUIRE( all.count( String_t( module ) ) == 1 );
+			CHECK( all.at( String_t( module ) ) == boostdep::build_filtered_module_dependency_map( graph, module ) );
+		}
+	};
+
+	const auto root = make_test_tree( "batch_filter" );
+	check( boostdep::scan_all_boost_modules( root, boostdep::ScanOptions{} ) );
+	fs::remove_all( root );
+
+	// random graphs with lots of include cycles, within and across modules
+	std::mt19937 gen{0};
+	for( int round = 0; round < 20; ++round ) {
+		const int                       file_cnt = 1 + static_cast<int>( gen() % 200 );
+		std::vector<boostdep::FileInfo> files;
+		for( int i = 0; i < file_cnt; ++i ) {
+			const auto module = "m" + std::to_string( gen() % 12 );
+			files.push_back( {"boost/f" + std::to_string( i ) + ".hpp", {}, module, boostdep::FileCategory::Header} );
+		}
+		for( auto& f : files ) {
+			for( auto cnt = gen() % 4; cnt-- > 0; ) {
+				f.included_files.push_back( files[gen() % files.size()].name );
+			}
+		}
+		check( files );
+	}
+}
+
+TEST_CASE( "parallel_module_dependency_map_matches_reference", "[boost_dep_graph_tests]" )
+{
+	// enough files to be split across several tasks
+	std::mt19937                    gen{1};
+	std::vector<boostdep::FileInfo> files;
+	for( int i = 0; i < 5000; ++i ) {
+		const auto module = "m" + std::to_string( i / 40 );
+		files.push_back( {"boost/f" + std::to_string( i ) + ".hpp", {}, module, boostdep::FileCategory::Header} );
+	}
+	std::map<std::string, std::set<std::string>> reference;
+	for( auto& f : files ) {
+		auto& deps = reference[f.module_name];
+		for( auto cnt = gen() % 6; cnt-- > 0; ) {
+			const auto& inc = files[gen() % files.size()];
+			f.included_files.push_back( inc.name );
+			if( inc.module_name != f.module_name ) {
+				deps.insert( inc.module_name );
+			}
+		}
+	}
+
+	boostdep::DependencyInfo expected;
+	for( const auto& [module, deps] : reference ) {
+		expected[module].assign( deps.begin(), deps.end() );
+	}
+
+	boostdep::AnalysisStats stats;
+	CHECK( boostdep::to_dependency_info( boostdep::build_module_dependency_map( files, &stats ) ) == expected );
+	CHECK( boostdep::to_dependency_info( boostdep::build_module_dependency_map( boostdep::make_file_graph( files ) ) )
+		   == expected );
+	CHECK( stats.unresolved_includes == 0 );
+	CHECK( stats.resolved_includes
+		   == std::accumulate( files.begin(), files.end(), std::size_t{0}, []( std::size_t sum, const auto& f ) {
+				  return sum + f.included_files.size();
+			  } ) );
+}
+
+TEST_CASE( "unresolved_includes_are_deduplicated", "[boost_dep_graph_tests]" )
+{
+	using boostdep::FileCategory;
+	const std::vector<boostdep::FileInfo> files = {
+		{"boost/a/x.hpp", {"boost/b/y.hpp", "boost/missing.hpp"}, "a", FileCategory::Header},
+		{"boost/a/z.hpp", {"boost/missing.hpp", "boost/other.hpp"}, "a", FileCategory::Header},
+		{"boost/b/y.hpp", {"boost/missing.hpp"}, "b", FileCategory::Header},
+	};
+
+	const auto check = []( const boostdep::AnalysisStats& stats ) {
+		CHECK( stats.unresolved_includes == 4 );
+		CHECK( stats.unresolved.total() == 4 );
+		CHECK( stats.unresolved.size() == 3 );
+		CHECK( stats.unresolved.count( "a", "boost/missing.hpp" ) == 2 );
+		CHECK( stats.unresolved.count( "a", "boost/other.hpp" ) == 1 );
+		CHECK( stats.unresolved.count( "b", "boost/missing.hpp" ) == 1 );
+		CHECK( stats.unresolved.count( "b", "boost/other.hpp" ) == 0 );
+		CHECK( stats.unresolved.entries().front().module == "a" );
+	};
+
+	boostdep::AnalysisStats file_stats;
+	boostdep::build_module_dependency_map( files, &file_stats );
+	check( file_stats );
+
+	boostdep::AnalysisStats graph_stats;
+	boostdep::build_module_dependency_map( boostdep::make_file_graph( files ), &graph_stats );
+	check( graph_stats );
+
+	// the filtered map of b doesn't contain the files of a
+	boostdep::AnalysisStats filtered_stats;
+	boostdep::build_filtered_module_dependency_map( files, "b", &filtered_stats );
+	CHECK( filtered_stats.unresolved.size() == 1 );
+
+	file_stats.unresolved.merge( graph_stats.unresolved );
+	CHECK( file_stats.unresolved.count( "a", "boost/missing.hpp" ) == 4 );
+
+	std::ostringstream out;
+	boostdep::print_unresolved_includes( out, graph_stats.unresolved, 1 );
+	CHECK( out.str().find( "Unresolved includes: 4 (3 distinct)" ) != std::string::npos );
+	CHECK( out.str().find( "boost/missing.hpp" ) != std::string::npos );
+	CHECK( out.str().find( "and 2 more" ) != std::string::npos );
+}
+
+TEST_CASE( "dependency_graph_adjacency", "[boost_dep_graph_tests]" )
+{
+	using boostdep::DependencyGraph;
+	const boostdep::DependencyInfo info = {
+		{"c", {"a", "b", "a", "unknown"}},
+		{"a", {}},
+		{"b", {"a"}},
+	};
+
+	const DependencyGraph graph( info );
+	REQUIRE( graph.size() == 3 );
+	CHECK( graph.edge_count() == 3 );
+	CHECK( graph.name( 0 ) == "a" );
+	CHECK( graph.find( "c" ) == 2 );
+	CHECK( graph.find( "unknown" ) == DependencyGraph::npos );
+	CHECK( graph.find( "" ) == DependencyGraph::npos );
+
+	const auto c = graph.deps( graph.find( "c" ) );
+	CHECK( std::vector<DependencyGraph::NodeId>( c.begin(), c.end() ) == std::vector<DependencyGraph::NodeId>{0, 1} );
+	const auto a = graph.rev_deps( graph.find( "a" ) );
+	CHECK( std::vector<DependencyGraph::NodeId>( a.begin(), a.end() ) == std::vector<DependencyGraph::NodeId>{1, 2} );
+	CHECK( graph.rev_deps( graph.find( "c" ) ).empty() );
+
+	// duplicates and dependencies on unknown nodes are gone
+	const auto roundtrip = boostdep::to_dependency_info( graph );
+	CHECK( roundtrip.at( "c" ) == std::vector<String_t>{"a", "b"} );
+	CHECK( DependencyGraph( roundtrip ) == graph );
+	CHECK( DependencyGraph() != graph );
+	CHECK( DependencyGraph().find( "a" ) == DependencyGraph::npos );
+}
+
+TEST_CASE( "scan_git_revision_matches_checkout", "[boost_dep_graph_tests]" )
+{
+	const auto log = " > \"" + ( fs::temp_directory_path() / "bdg_git_test.log" ).string() + "\" 2>&1";
+	const auto git = [&]( const fs::path& dir, const std::string& args ) {
+		const auto cmd = "git -C \"" + dir.string()
+						 + "\" -c user.name=test -c user.email=test@example.com -c protocol.file.allow=always " + args
+						 + log;
+		return std::system( cmd.c_str() ) == 0;
+	};
+	if( !git::Repository::is_supported() || std::system( ( "git --version" + log ).c_str() ) != 0 ) {
+		WARN( "git or zlib not available - skipping test" );
+		return;
+	}
+
+	const auto root       = make_test_tree( "git" );
+	const auto module_src = fs::temp_directory_path() / "bdg_test_tree_git_module_b";
+	fs::remove_all( module_src );
+	write_file( root / "libs/a/include/boost/a/readme.txt", "#include <boost/b/b.hpp>\n" );
+	write_file( root / "libs/a/include/boost/a/empty.hpp", "" ); // pack entry with size 0
+
+	// module b becomes a submodule
+	fs::rename( root / "libs/b", module_src );
+	REQUIRE( git( module_src, "init -q" ) );
+	REQUIRE( git( module_src, "add -A" ) );
+	REQUIRE( git( module_src, "commit -q -m b" ) );
+	REQUIRE( git( root, "init -q" ) );
+	REQUIRE( git( root, "submodule add -q \"" + module_src.generic_string() + "\" libs/b" ) );
+	REQUIRE( git( root, "add -A" ) );
+	REQUIRE( git( root, "commit -q -m boost" ) );
+	REQUIRE( git( root, "tag release" ) );
+	REQUIRE( git( root, "gc -q" ) ); // superproject objects end up in a pack, the submodule's stay loose
+
+	const boostdep::ScanOptions options;
+	const auto                  checkout = sorted_by_name( boostdep::scan_all_boost_modules( root, options ) );
+
+	// changes in the working tree must not be visible
+	write_file( root / "libs/a/include/boost/a.hpp", "#include <boost/b/new.hpp>\n" );
+	fs::remove_all( root / "libs/b/include" );
+
+	for( const auto* revision : {"release", "HEAD", "master"} ) {
+		auto git_options         = options;
+		git_options.git_revision = revision;
+		if( String_t( revision ) == "master" && !fs::exists( root / ".git/refs/heads/master" )
+			&& !fs::exists( root / ".git/packed-refs" ) ) {
+			continue; // default branch might be named differently
+		}
+
+		const auto scanned = sorted_by_name( boostdep::scan_all_boost_modules( root, git_options ) );
+		REQUIRE( scanned.size() == checkout.size() );
+		for( std::size_t i = 0; i < checkout.size(); ++i ) {
+			CHECK( scanned[i].name == checkout[i].name );
+			CHECK( scanned[i].module_name == checkout[i].module_name );
+			CHECK( scanned[i].category == checkout[i].category );
+			CHECK( scanned[i].included_files == checkout[i].included_files );
+		}
+	}
+
+	// files the classifier skips don't count as scanned files of their module
+	boostdep::FileClassifier classifier;
+	auto                     classified_options = options;
+	classified_options.git_revision             = "release";
+	classified_options.classifier               = &classifier;
+	boostdep::ScanStats stats;
+	const auto          classified = boostdep::scan_all_boost_modules( root, classified_options, &stats );
+	std::size_t         module_files = 0;
+	for( const auto& m : stats.modules ) {
+		module_files += m.files;
+	}
+	CHECK( stats.skipped_files == 1 );
+	CHECK( classified.size() == checkout.size() - 1 );
+	CHECK( module_files == classified.size() );
+
+	auto bad_options         = options;
+	bad_options.git_revision = "no_such_branch";
+	CHECK_THROWS( boostdep::scan_all_boost_modules( root, bad_options ) );
+
+	fs::remove_all( root );
+	fs::remove_all( module_src );
+}
+
+TEST_CASE( "content_dedup_reuses_parsed_files", "[boost_dep_graph_tests]" )
+{
+	const auto root = make_test_tree( "dedup" );
+	// same content as in another module
+	fs::copy_file( root / "libs/a/include/boost/a.hpp", root / "libs/b/include/boost/b/copy_of_a.hpp" );
+
+	boostdep::ContentDedupTable table;
+	boostdep::ScanOptions       options;
+	options.dedup = &table;
+
+	const auto plain = sorted_by_name( boostdep::scan_all_boost_modules( root, boostdep::ScanOptions{} ) );
+	const auto first = sorted_by_name( boostdep::scan_all_boost_modules( root, options ) );
+	CHECK( table.misses() + table.hits() == plain.size() );
+	CHECK( table.size() < plain.size() );
+
+	const auto second = sorted_by_name( boostdep::scan_all_boost_modules( root, options ) );
+	CHECK( table.hits() >= plain.size() );
+
+	REQUIRE( first.size() == plain.size() );
+	REQUIRE( second.size() == plain.size() );
+	for( std::size_t i = 0; i < plain.size(); ++i ) {
+		CHECK( first[i].included_files == plain[i].included_files );
+		CHECK( second[i].included_files == plain[i].included_files );
+	}
+
+	fs::remove_all( root );
+}
@@ -1,11 +1,16 @@
+#include <core/task_scheduler.hpp>
 #include <core/utils.hpp>
 
 #include <catch2/catch.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iostream>
 #include <numeric>
 #include <random>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
 TEST_CASE( "sort_to_the_middle", "[boost_dep_graph_tests]" )
@@ -25,3 +30,93 @@ TEST_CASE( "sort_to_the_middle", "[boost_dep_graph_tests]" )
 		CHECK( ref == data );
 	}
 }
+
+TEST_CASE( "hash64_matches_xxhash64", "[boost_dep_graph_tests]" )
+{
+	// reference values of xxHash64, covering the short and the 32 byte block path
+	CHECK( mdev::hash64( "" ) == 0xEF46DB3751D8E999ull );
+	CHECK( mdev::hash64( "a" ) == 0xD24EC4F1A98C6E5Bull );
+	CHECK( mdev::hash64( "abc" ) == 0x44BC2CF5AD770999ull );
+}
+
+TEST_CASE( "task_scheduler_nested_spawn", "[boost_dep_graph_tests]" )
+{
+	mdev::TaskScheduler scheduler( 4 );
+
+	// binary tree of tasks: every task below the maximum depth spawns two more
+	std::atomic<int>           executed{0};
+	std::function<void( int )> node = [&]( int depth ) {
+		executed++;
+		if( depth < 10 ) {
+			scheduler.spawn( [&, depth]( std::size_t ) { node( depth + 1 ); } );
+			scheduler.spawn( [&, depth]( std::size_t ) { node( depth + 1 ); } );
+		}
+	};
+	scheduler.spawn( [&]( std::size_t ) { node( 0 ); } );
+	scheduler.run();
+	CHECK( executed == ( 1 << 11 ) - 1 );
+
+	// a scheduler that runs inside a task of another one
+	std::atomic<int>  inner_tasks{0};
+	std::atomic<bool> still_outer_worker{true};
+	for( int i = 0; i < 8; ++i ) {
+		scheduler.spawn( [&]( std::size_t ) {
+			mdev::TaskScheduler inner( 2 );
+			for( int j = 0; j < 16; ++j ) {
+				inner.spawn( [&]( std::size_t ) { inner_tasks++; } );
+			}
+			inner.run();
+			if( !scheduler.in_worker() ) {
+				still_outer_worker = false;
+			}
+			scheduler.spawn( [&]( std::size_t ) { inner_tasks++; } );
+		} );
+	}
+	scheduler.run();
+	CHECK( inner_tasks == 8 * 17 );
+	CHECK( still_outer_worker );
+	CHECK( !scheduler.in_worker() );
+}
+
+TEST_CASE( "task_scheduler_propagates_exceptions", "[boost_dep_graph_tests]" )
+{
+	mdev::TaskScheduler scheduler( 3 );
+	std::atomic<int>    executed{0};
+	for( int i = 0; i < 20; ++i ) {
+		scheduler.spawn( [&, i]( std::size_t ) {
+			executed++;
+			if( i == 7 ) {
+				throw std::runtime_error( "task failed" );
+			}
+		} );
+	}
+	CHECK_THROWS_AS( scheduler.run(), std::runtime_error );
+	CHECK( executed == 20 ); // the other tasks still run
+
+	// the error is reported only once
+	scheduler.spawn( [&]( std::size_t ) { executed++; } );
+	CHECK_NOTHROW( scheduler.run() );
+	CHECK( executed == 21 );
+}
+
+TEST_CASE( "task_scheduler_single_thread", "[boost_dep_graph_tests]" )
+{
+	mdev::TaskScheduler scheduler( 1 );
+	REQUIRE( scheduler.thread_count() == 1 );
+
+	const auto       caller = std::this_thread::get_id();
+	std::vector<int> order;
+	bool             other_thread = false;
+	for( int i = 0; i < 5; ++i ) {
+		scheduler.spawn( [&, i]( std::size_t worker ) {
+			other_thread |= worker != 0 || std::this_thread::get_id() != caller;
+			order.push_back( i );
+		} );
+	}
+	const auto stats = scheduler.run();
+	CHECK( !other_thread );
+	REQUIRE( stats.size() == 1 );
+	CHECK( stats[0].tasks == 5 );
+	CHECK( stats[0].steals == 0 );
+	CHECK( order == std::vector<int>{4, 3, 2, 1, 0} ); // the queue of a worker is processed last in, first out
+}